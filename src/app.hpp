@@ -9,6 +9,7 @@
 
 #include "opts.hpp"
 #include "srs.hpp"
+#include "bounds.hpp"
 #include "log.hpp"
 #include <cmath>
 #include <numbers>
@@ -17,6 +18,8 @@
 #include <filesystem>
 #include <vector>
 #include <optional>
+#include <cstddef>
+#include <cstdint>
 
 class App {
 	App(Opts const &&opts) :
@@ -30,11 +33,16 @@ class App {
 		smooth     (!opts.raw && !opts.simplify),
 		multi      (opts.multi),
 		lines      (opts.lines),
+		reorder    (opts.reorder),
 		discard    (opts.discard->begin(), opts.discard->end()),
 		overwrite  (opts.overwrite),
 		tile_paths (opts.tile_paths),
+		stream     (opts.stream),
+		cache      (opts.cache),
 		threads    (opts.threads->front()),
 		io_threads (opts.threads->back()),
+		prefetch   (opts.prefetch ? opts.prefetch->front() : 0),
+		budget     ((opts.prefetch && opts.prefetch->size() > 1 ? opts.prefetch->back() : 1024) * 1048576ull),
 		log        (!opts.quiet)
 	{
 		if (opts.path == "-")
@@ -48,6 +56,12 @@ class App {
 
 		if (opts.epsg)
 			srs.emplace(*opts.epsg);
+
+		if (opts.bounds) {
+			bounds.emplace();
+			bounds->xmin = (*opts.bounds)[0], bounds->ymin = (*opts.bounds)[1];
+			bounds->xmax = (*opts.bounds)[2], bounds->ymax = (*opts.bounds)[3];
+		}
 	}
 
 	using Discard = std::unordered_set<unsigned char>;
@@ -55,6 +69,7 @@ class App {
 	using Paths = std::vector<Path>;
 	using OptionalPath = std::optional<Path>;
 	using OptionalDouble = std::optional<double>;
+	using OptionalBounds = std::optional<Bounds>;
 
 public:
 	OptionalDouble width;
@@ -67,13 +82,19 @@ public:
 	bool           smooth;
 	bool           multi;
 	bool           lines;
+	bool           reorder;
 	Discard        discard;
+	OptionalBounds bounds;
 	bool           overwrite;
 	Paths          tile_paths;
+	bool           stream;
+	OptionalPath   cache;
 	OptionalPath   path;
 	OptionalSRS    srs;
 	int            threads;
 	int            io_threads;
+	std::size_t    prefetch;
+	std::uintmax_t budget;
 	Log            log;
 
 	App(int argc, char *argv[]) :
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "point.hpp"
+#include "bounds.hpp"
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+
+struct Batch {
+	using Discard = std::array<bool, 256>;
+	using Values = std::vector<double>;
+	using Bytes = std::vector<unsigned char>;
+
+	std::size_t static constexpr capacity = 4096;
+
+	std::size_t size;
+	Values x, y, z;
+	Bytes classification, key_point, withheld, overlap, accept;
+
+	Batch() :
+		size(0),
+		x(capacity), y(capacity), z(capacity),
+		classification(capacity), key_point(capacity), withheld(capacity), overlap(capacity), accept(capacity)
+	{ }
+
+	void filter(Discard const &discard) {
+		for (std::size_t index = 0; index < size; ++index)
+			accept[index] = !withheld[index] && (key_point[index] || !discard[classification[index]]);
+	}
+
+	void clip(Bounds const &bounds) {
+		for (std::size_t index = 0; index < size; ++index)
+			accept[index] &= x[index] >= bounds.xmin && x[index] <= bounds.xmax && y[index] >= bounds.ymin && y[index] <= bounds.ymax;
+	}
+
+	auto bounds() const {
+		auto bounds = Bounds();
+		for (std::size_t index = 0; index < size; ++index) {
+			bounds.xmin = std::min(bounds.xmin, x[index]), bounds.xmax = std::max(bounds.xmax, x[index]);
+			bounds.ymin = std::min(bounds.ymin, y[index]), bounds.ymax = std::max(bounds.ymax, y[index]);
+		}
+		return bounds;
+	}
+
+	auto operator[](std::size_t index) const {
+		return Point(x[index], y[index], z[index], classification[index], key_point[index], withheld[index], overlap[index]);
+	}
+};
+
+#endif
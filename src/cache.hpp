@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "app.hpp"
+#include "point.hpp"
+#include "input.hpp"
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <system_error>
+#include <thread>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+
+class Cache {
+	using Path = std::filesystem::path;
+
+	static constexpr char magic[8] = {'l', '2', 'p', 'c', 'a', 'c', 'h', 'e'};
+	auto static constexpr record_length = 22;
+
+	Path path;
+	std::string key;
+
+public:
+	Cache(App const &app, Path const &tile_path, double resolution) {
+		auto discard = std::vector<int>(app.discard.begin(), app.discard.end());
+		std::sort(discard.begin(), discard.end());
+
+		auto stream = std::ostringstream();
+		stream << std::filesystem::absolute(tile_path).string() << '\n';
+		stream << std::filesystem::file_size(tile_path) << '\n';
+		stream << std::filesystem::last_write_time(tile_path).time_since_epoch().count() << '\n';
+		stream << std::hexfloat << resolution << '\n';
+		for (auto const classification: discard)
+			stream << classification << ',';
+		if (app.bounds)
+			stream << '\n' << app.bounds->xmin << ',' << app.bounds->ymin << ',' << app.bounds->xmax << ',' << app.bounds->ymax;
+		key = stream.str();
+
+		auto name = std::ostringstream();
+		name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>()(key) << ".bin";
+		path = *app.cache / name.str();
+	}
+
+	auto read(std::vector<Point> &points) const try {
+		if (!std::filesystem::is_regular_file(path))
+			return false;
+
+		auto input = Input(path);
+		auto header = std::string(sizeof(magic) + key.size(), '\0');
+		input.read(header.data(), header.size());
+		if (header != std::string(magic, sizeof(magic)) + key)
+			return false;
+
+		auto count = std::uint64_t();
+		input.read(reinterpret_cast<char *>(&count), sizeof(count));
+		points.reserve(count);
+		for (auto record = input.view(count * record_length), end = record + count * record_length; record < end; record += record_length) {
+			double x, y;
+			float z;
+			std::memcpy(&x, record, 8);
+			std::memcpy(&y, record + 8, 8);
+			std::memcpy(&z, record + 16, 4);
+			auto const flags = record[21];
+			points.emplace_back(x, y, z, record[20], flags & 1, flags & 2, flags & 4);
+		}
+		return true;
+	} catch (std::ios_base::failure &) {
+		points.clear();
+		return false;
+	}
+
+	template <typename Runs>
+	void write(Runs const &runs) const {
+		auto count = std::uint64_t(0);
+		for (auto const &run: runs)
+			count += run.size();
+
+		auto suffix = std::ostringstream();
+		suffix << '.' << ::getpid() << '.' << std::this_thread::get_id() << ".tmp";
+		auto const temporary = Path(path).concat(suffix.str());
+
+		try {
+			auto output = std::ofstream(temporary, std::ios_base::binary);
+			output.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+			output.write(magic, sizeof(magic));
+			output << key;
+			output.write(reinterpret_cast<char const *>(&count), sizeof(count));
+
+			char record[record_length];
+			for (auto const &run: runs)
+				for (auto const &point: run) {
+					double const x = point[0], y = point[1];
+					std::memcpy(record, &x, 8);
+					std::memcpy(record + 8, &y, 8);
+					std::memcpy(record + 16, &point.elevation, 4);
+					record[20] = point.classification;
+					record[21] = point.key_point | point.withheld << 1 | point.overlap << 2;
+					output.write(record, record_length);
+				}
+			output.close();
+			std::filesystem::rename(temporary, path);
+		} catch (std::system_error &) {
+			auto error = std::error_code();
+			std::filesystem::remove(temporary, error);
+			std::cerr << "warning: problem writing cache file " + path.string() + "\n";
+		}
+	}
+};
+
+#endif
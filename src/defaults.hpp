@@ -9,67 +9,97 @@
 
 #include "app.hpp"
 #include "points.hpp"
+#include "thin.hpp"
+#include "tiles.hpp"
+#include "point.hpp"
+#include "bounds.hpp"
 #include "mesh.hpp"
+#include "queue.hpp"
 #include <vector>
-#include <filesystem>
-#include <mutex>
-#include <exception>
-#include <thread>
+#include <optional>
+#include <utility>
+#include <stdexcept>
 #include <algorithm>
 #include <iomanip>
+#include <cmath>
+#include <cstddef>
 
 class Defaults {
-	std::vector<double> medians;
-
-	using Paths = std::vector<std::filesystem::path>;
-	using PathIterator = Paths::const_iterator;
-
-	Defaults() = default;
-
-	void load(App const &app, PathIterator begin, PathIterator end, std::mutex &mutex, std::exception_ptr &exception, int threads) {
-		if (auto lock = std::lock_guard(mutex); exception)
-			return;
-		try {
-			if (begin + 1 == end) {
-				auto points = Points(app, *begin);
-				auto mesh = Mesh(points);
-				if (auto const median = mesh.median_length(); median)
-					medians.push_back(*median);
-			} else {
-				auto const middle = begin + (end - begin) / 2;
-				auto defaults1 = Defaults();
-				auto defaults2 = Defaults();
-				if (1 == threads) {
-					defaults1.load(app, begin, middle, mutex, exception, 1);
-					defaults2.load(app, middle, end, mutex, exception, 1);
-				} else {
-					auto thread1 = std::thread([&]() {
-						defaults1.load(app, begin, middle, mutex, exception, threads/2);
-					}), thread2 = std::thread([&]() {
-						defaults2.load(app, middle, end, mutex, exception, threads - threads/2);
-					});
-					thread1.join(), thread2.join();
-				}
-				medians.insert(medians.end(), defaults1.medians.begin(), defaults1.medians.end());
-				medians.insert(medians.end(), defaults2.medians.begin(), defaults2.medians.end());
-			}
-		} catch (std::runtime_error &) {
-			auto lock = std::lock_guard(mutex);
-			exception = std::current_exception();
+	auto static constexpr sample_tiles = 16;
+	auto static constexpr strata = 4;
+	auto static constexpr patch_points = 4096;
+	auto static constexpr coarsen = 2.0;
+
+	using Patch = std::pair<PointIterator, PointIterator>;
+	using Patches = std::vector<Patch>;
+
+	static auto sample(Points &points, Bounds const &bounds) {
+		auto const width = (bounds.xmax - bounds.xmin) / strata;
+		auto const height = (bounds.ymax - bounds.ymin) / strata;
+		auto patches = Patches();
+
+		if (!(width > 0 && height > 0) || points.size() < strata * strata * patch_points) {
+			patches.emplace_back(points.begin(), points.end());
+			return patches;
+		}
+
+		auto const side = std::sqrt(patch_points * width * height * strata * strata / points.size());
+		auto const patch = [&](Point const &point) {
+			auto const column = std::clamp<int>((point[0] - bounds.xmin) / width, 0, strata - 1);
+			auto const row    = std::clamp<int>((point[1] - bounds.ymin) / height, 0, strata - 1);
+			auto const x = bounds.xmin + (column + 0.5) * width;
+			auto const y = bounds.ymin + (row + 0.5) * height;
+			return std::abs(point[0] - x) < side / 2 && std::abs(point[1] - y) < side / 2 ? column + row * strata : -1;
+		};
+
+		auto const end = std::partition(points.begin(), points.end(), [&](auto const &point) {
+			return patch(point) >= 0;
+		});
+		std::sort(points.begin(), end, [&](auto const &point1, auto const &point2) {
+			return patch(point1) < patch(point2);
+		});
+
+		for (auto begin = points.begin(); begin != end; ) {
+			auto const next = std::find_if(begin, end, [&, id = patch(*begin)](auto const &point) {
+				return patch(point) != id;
+			});
+			patches.emplace_back(begin, next);
+			begin = next;
 		}
+		return patches;
 	}
 
 public:
-	Defaults(App &app) {
+	Points::Decodes decoded;
+
+	Defaults(App &app, Tiles const &tiles) {
 		if (!app.width) {
-			auto mutex = std::mutex();
-			auto exception = std::exception_ptr();
+			auto indices = Queue::Indices();
+			for (std::size_t index = 0; index < app.tile_paths.size(); ++index)
+				if (tiles.sizes[index] > 0)
+					indices.push_back(index);
+
+			auto const samples = std::min<std::size_t>(indices.size(), std::max(sample_tiles, app.io_threads));
+			for (std::size_t sample = 0; sample < samples; ++sample)
+				indices[sample] = indices[sample * indices.size() / samples];
+			indices.resize(samples);
+
+			auto const queue = Queue(app.tile_paths, indices, app.prefetch, app.budget);
+			auto tile_medians = std::vector<std::optional<double>>(app.tile_paths.size());
 
-			app.log("reading", app.tile_paths.size(), "tile");
-			load(app, app.tile_paths.begin(), app.tile_paths.end(), mutex, exception, app.io_threads);
+			decoded.resize(app.tile_paths.size());
+			app.log("sampling", samples, "tile");
+			queue(app.io_threads, [&](std::size_t index, int threads) {
+				auto points = Points(app, app.tile_paths[index], threads);
+				auto const &median = tile_medians[index] = Mesh(points, sample(points, tiles.bounds[index])).lengths().median();
+				if (median)
+					decoded[index].emplace(points.decode(Thin(std::max(Points::resolution(4 * *median) / coarsen, Thin::min_resolution)), threads));
+			});
 
-			if (exception)
-				std::rethrow_exception(exception);
+			auto medians = std::vector<double>();
+			for (auto const &tile_median: tile_medians)
+				if (tile_median)
+					medians.push_back(*tile_median);
 
 			auto const begin = medians.begin(), end = medians.end();
 			auto const median = begin + (end - begin) / 2;
@@ -38,6 +38,8 @@ public:
 		empty.assign(rows * columns, true);
 
 		for (auto const &bounds: tile_bounds) {
+			if (bounds.empty())
+				continue;
 			auto const i0 = static_cast<int>(bounds.ymin / resolution) - imin;
 			auto const i1 = static_cast<int>(bounds.ymax / resolution) - imin;
 			auto const j0 = static_cast<int>(bounds.xmin / resolution) - jmin;
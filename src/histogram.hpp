@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+class Histogram {
+	auto static constexpr divisions = 64;
+	auto static constexpr octaves = 64;
+
+	std::vector<std::size_t> counts;
+	std::size_t total;
+
+public:
+	Histogram() : counts(divisions * octaves, 0), total(0) { }
+
+	void insert(double sqnorm) {
+		if (sqnorm > 0) {
+			auto const bin = std::floor((0.5 * std::log2(sqnorm) + octaves / 2) * divisions);
+			++counts[std::clamp<double>(bin, 0, counts.size() - 1)];
+			++total;
+		}
+	}
+
+	auto median() const {
+		auto remaining = total / 2;
+		for (std::size_t bin = 0; bin < counts.size(); ++bin)
+			if (counts[bin] > remaining)
+				return std::optional(std::exp2((bin + 0.5) / divisions - octaves / 2));
+			else
+				remaining -= counts[bin];
+		return std::optional<double>();
+	}
+};
+
+#endif
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <ios>
+#include <bit>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static_assert(std::endian::native == std::endian::big || std::endian::native == std::endian::little);
+
+class Input {
+	using Path = std::filesystem::path;
+
+	char const *data;
+	std::size_t length;
+	std::size_t position;
+
+	static auto spool(Path const &path) {
+		auto static constexpr block_size = 1 << 16;
+		static auto mutex = std::mutex();
+		static auto spools = std::map<Path, int>();
+
+		auto lock = std::lock_guard(mutex);
+		if (auto const existing = spools.find(path); existing != spools.end())
+			return existing->second;
+
+		auto const source = ::open(path.c_str(), O_RDONLY);
+		if (source < 0)
+			throw std::ios_base::failure("can't open file");
+
+		auto name = (std::filesystem::temp_directory_path() / "las2poly.XXXXXX").string();
+		auto const spooled = ::mkstemp(name.data());
+		if (spooled < 0) {
+			::close(source);
+			throw std::ios_base::failure("can't spool file");
+		}
+		::unlink(name.c_str());
+
+		char buffer[block_size];
+		for (auto count = ::ssize_t(1); count > 0; ) {
+			count = ::read(source, buffer, block_size);
+			for (auto offset = ::ssize_t(0); count > 0 && offset < count; )
+				if (auto const written = ::write(spooled, buffer + offset, count - offset); written < 0)
+					count = -1;
+				else
+					offset += written;
+			if (count < 0) {
+				::close(source), ::close(spooled);
+				throw std::ios_base::failure("can't spool file");
+			}
+		}
+		::close(source);
+
+		return spools[path] = spooled;
+	}
+
+	void check(std::size_t count) const {
+		if (count > length - position)
+			throw std::ios_base::failure("unexpected end of file");
+	}
+
+public:
+	Input(Path const &path) : data(nullptr), length(0), position(0) {
+		auto error = std::error_code();
+		auto const spooled = std::filesystem::is_fifo(path, error);
+		auto const descriptor = spooled ? spool(path) : ::open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			throw std::ios_base::failure("can't open file");
+
+		struct stat status;
+		if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+			auto const mapping = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (mapping != MAP_FAILED) {
+				::madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+				data = static_cast<char const *>(mapping);
+				length = status.st_size;
+			}
+		}
+		if (!spooled)
+			::close(descriptor);
+
+		if (!data)
+			throw std::ios_base::failure("can't map file");
+	}
+
+	~Input() {
+		::munmap(const_cast<char *>(data), length);
+	}
+
+	Input(Input const &) = delete;
+	Input &operator=(Input const &) = delete;
+
+	void read(char *buffer, std::size_t count) {
+		check(count);
+		std::memcpy(buffer, data + position, count);
+		position += count;
+	}
+
+	template <typename Value>
+	void read(Value &value) {
+		read(reinterpret_cast<char *>(&value), sizeof(value));
+		if constexpr (std::endian::native == std::endian::big && sizeof(value) > 1)
+			std::reverse(reinterpret_cast<char *>(&value), reinterpret_cast<char *>(&value) + sizeof(value));
+	}
+
+	auto view(std::size_t count) {
+		check(count);
+		auto const buffer = data + position;
+		position += count;
+		return buffer;
+	}
+
+	void skip(std::size_t offset) {
+		check(offset);
+		position += offset;
+	}
+
+	void seek(std::size_t new_position) {
+		if (new_position > length)
+			throw std::ios_base::failure("unexpected end of file");
+		position = new_position;
+	}
+};
+
+#endif
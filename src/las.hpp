@@ -12,21 +12,27 @@
 #include "lazperf/decoder.hpp"
 #include "lazperf/decompressor.hpp"
 
+#include "input.hpp"
 #include "srs.hpp"
-#include "point.hpp"
+#include "batch.hpp"
+#include "bounds.hpp"
 #include <bit>
 #include <optional>
 #include <functional>
-#include <iostream>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include <string>
 #include <deque>
+#include <utility>
+#include <vector>
 #include <variant>
 #include <array>
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
+#include <numeric>
+#include <cmath>
 
 static_assert(std::endian::native == std::endian::big || std::endian::native == std::endian::little);
 
@@ -40,8 +46,8 @@ class LAS {
 			las.read_chunk_table();
 		}
 
-		void operator()(char *buffer) {
-			las.read_buffer(buffer, decompressor);
+		auto operator()() {
+			return las.read_buffer(decompressor);
 		}
 	};
 
@@ -50,8 +56,8 @@ class LAS {
 
 		LASPointReader(LAS &las) : las(las) { }
 
-		void operator()(char *buffer) {
-			las.read_buffer(buffer);
+		auto operator()() {
+			return las.read_buffer();
 		}
 	};
 
@@ -60,12 +66,11 @@ class LAS {
 	using LAZPointReader2 = LAZPointReader<lazperf::point_decompressor_2>;
 	using LAZPointReader3 = LAZPointReader<lazperf::point_decompressor_3>;
 	using LAZPointReader6 = LAZPointReader<lazperf::point_decompressor_6>;
-	using LAZPointReader7 = LAZPointReader<lazperf::point_decompressor_7>;
-	using LAZPointReader8 = LAZPointReader<lazperf::point_decompressor_8>;
 
 	using LAZperfCallback = std::function<void(unsigned char *, std::size_t)>;
+	using Nodes = std::vector<std::pair<std::uint64_t, std::uint64_t>>;
 
-	std::istream &input;
+	Input &input;
 	LAZperfCallback lazperf_callback;
 
 	std::uint8_t version_major, version_minor;
@@ -77,13 +82,20 @@ class LAS {
 	std::uint32_t legacy_number_of_point_records;
 	double x_scale, y_scale, z_scale;
 	double x_offset, y_offset, z_offset;
+	double max_x, min_x, max_y, min_y;
 	std::uint64_t start_of_extended_variable_length_records;
 	std::uint32_t number_of_extended_variable_length_records;
 	std::uint64_t number_of_point_records;
 	std::uint32_t chunk_size;
+	std::optional<double> copc_spacing;
+	std::uint64_t root_hierarchy_offset, root_hierarchy_size;
 
 	std::size_t extra_bytes;
 	std::string point_data_record;
+	std::string chunk_header;
+	std::size_t chunk_header_position;
+
+	std::array<std::vector<std::int32_t>, 3> coordinates;
 
 	std::deque<std::uint64_t> chunk_points;
 	std::deque<std::uint64_t> chunk_lengths;
@@ -95,9 +107,7 @@ class LAS {
 		LAZPointReader1,
 		LAZPointReader2,
 		LAZPointReader3,
-		LAZPointReader6,
-		LAZPointReader7,
-		LAZPointReader8
+		LAZPointReader6
 	> point_reader;
 
 	void read_values() { }
@@ -116,26 +126,25 @@ class LAS {
 
 	template <typename Arg, typename ...Args>
 	void read_values(Arg &arg, Args &...args) {
-		input.read(reinterpret_cast<char *>(&arg), sizeof(arg));
-		if constexpr (std::endian::native == std::endian::big && sizeof(arg) > 1)
-			std::reverse(reinterpret_cast<char *>(&arg), reinterpret_cast<char *>(&arg) + sizeof(arg));
+		input.read(arg);
 		read_values(args...);
 	}
 
 	template <typename ...Args>
 	void read_ahead(std::size_t offset, Args &...args) {
-		input.seekg(offset, std::ios_base::cur);
+		input.skip(offset);
 		read_values(args...);
 	}
 
 	void seek_to(std::size_t position) {
-		input.seekg(position);
+		input.seek(position);
 	}
 
 	template <typename LengthType>
 	void read_vlrs(std::uint32_t number_of_variable_length_records) {
 		std::array<char, 16> static constexpr  laszip_encoded_user_id = {"laszip encoded"};
 		std::array<char, 16> static constexpr lasf_projection_user_id = {"LASF_Projection"};
+		std::array<char, 16> static constexpr            copc_user_id = {"copc"};
 
 		for ( ; number_of_variable_length_records > 0; --number_of_variable_length_records) {
 			std::array<char, 16> user_id;
@@ -176,11 +185,40 @@ class LAS {
 						catch (SRS::InvalidEPSG &) { }
 				}
 				read_ahead(record_length_after_header - 8 * (number_of_keys + 1));
+			} else if (1 == record_id && copc_user_id == user_id) { // COPC info
+				double spacing;
+				read_ahead(32, spacing, root_hierarchy_offset, root_hierarchy_size);
+				read_ahead(record_length_after_header - 56);
+				copc_spacing = spacing;
 			} else
 				read_ahead(record_length_after_header);
 		}
 	}
 
+	void read_hierarchy(std::uint64_t offset, std::uint64_t length, double resolution, Nodes &nodes) {
+		auto const needed = [&](std::int32_t level) {
+			return level == 0 || std::ldexp(*copc_spacing, -level) >= resolution / 4;
+		};
+		auto pages = Nodes();
+
+		seek_to(offset);
+		for (auto count = length / 32; count > 0; --count) {
+			std::int32_t level, x, y, z;
+			std::uint64_t entry_offset;
+			std::int32_t byte_size, point_count;
+			read_values(level, x, y, z, entry_offset, byte_size, point_count);
+			if (level < 0 || byte_size < 0)
+				throw std::runtime_error("invalid COPC file");
+			if (point_count < 0 && needed(level))
+				pages.emplace_back(entry_offset, byte_size);
+			else if (point_count > 0 && needed(level))
+				nodes.emplace_back(entry_offset, point_count);
+		}
+
+		for (auto const &[page_offset, page_length]: pages)
+			read_hierarchy(page_offset, page_length, resolution, nodes);
+	}
+
 	void read_chunk_table() {
 		auto constexpr max_chunk_size = std::numeric_limits<uint32_t>::max();
 		auto const variable_chunk_size = max_chunk_size == chunk_size;
@@ -234,42 +272,114 @@ class LAS {
 		}
 	}
 
+	void trim_layers() {
+		auto constexpr point14_length = 30;
+		auto constexpr point14_layers = 9;
+		auto const layers = point14_layers + (7 == point_data_record_format) + 2 * (8 == point_data_record_format) + extra_bytes;
+
+		auto const first_point = input.view(point_data_record_length);
+		auto const point_count = input.view(4);
+		auto const layer_sizes = input.view(4 * layers);
+
+		chunk_header.assign(first_point, point14_length);
+		chunk_header.append(point_count, 4);
+		chunk_header.append(layer_sizes, 4 * point14_layers);
+		chunk_header_position = 0;
+	}
+
+	void assign(Nodes const &nodes) {
+		chunk_points.assign(1, 0);
+		chunk_offsets.clear();
+		for (auto const &[offset, points]: nodes) {
+			chunk_points.push_back(points);
+			chunk_offsets.push_back(offset);
+		}
+		size = std::accumulate(chunk_points.begin(), chunk_points.end(), std::size_t(0));
+	}
+
 	template <typename Decompressor>
-	void read_buffer(char *buffer, Decompressor &decompressor) {
-		while (chunk_points.front() == 0) {
-			decompressor.emplace(lazperf_callback, extra_bytes);
-			seek_to(chunk_offsets.front());
-			chunk_offsets.pop_front();
-			chunk_points.pop_front();
+	char const *read_buffer(Decompressor &decompressor) {
+		if (chunk_points.front() == 0) {
+			while (chunk_points.front() == 0) {
+				seek_to(chunk_offsets.front());
+				chunk_offsets.pop_front();
+				chunk_points.pop_front();
+			}
+			if (point_data_record_format < 6)
+				decompressor.emplace(lazperf_callback, extra_bytes);
+			else {
+				decompressor.emplace(lazperf_callback, 0);
+				trim_layers();
+			}
 		}
-		decompressor->decompress(buffer);
+		decompressor->decompress(point_data_record.data());
 		--chunk_points.front();
+		return point_data_record.data();
 	}
 
-	void read_buffer(char *buffer) {
-		input.read(buffer, point_data_record_length);
+	char const *read_buffer() {
+		return input.view(point_data_record_length);
 	}
 
-	void read_point_record(char *buffer) {
-		auto const read = [&](auto &point_reader) { point_reader(buffer); };
-		std::visit(read, point_reader);
+	template <bool extended, typename PointReader>
+	void read(PointReader &point_reader, Batch &batch) {
+		auto static constexpr key_point_mask = extended ? 0b00000010 : 0b01000000;
+		auto static constexpr withheld_mask  = extended ? 0b00000100 : 0b10000000;
+		auto static constexpr overlap_mask   = extended ? 0b00001000 : 0b00000000;
+		auto static constexpr class_mask     = extended ? 0b11111111 : 0b00011111;
+		auto static constexpr class_offset   = extended ? 16 : 15;
+
+		auto const integer = [](char const *bytes) {
+			auto value = std::int32_t();
+			if constexpr (std::endian::native == std::endian::big) {
+				char const reversed[4] = {bytes[3], bytes[2], bytes[1], bytes[0]};
+				std::memcpy(&value, reversed, 4);
+			} else
+				std::memcpy(&value, bytes, 4);
+			return value;
+		};
+
+		for (std::size_t index = 0; index < batch.size; ++index) {
+			auto const buffer = point_reader();
+			auto const flags = static_cast<std::uint8_t>(buffer[15]);
+			coordinates[0][index] = integer(buffer);
+			coordinates[1][index] = integer(buffer + 4);
+			coordinates[2][index] = integer(buffer + 8);
+			batch.key_point[index]      = 0 != (flags & key_point_mask);
+			batch.withheld[index]       = 0 != (flags & withheld_mask);
+			batch.classification[index] = static_cast<std::uint8_t>(buffer[class_offset]) & class_mask;
+			batch.overlap[index]        = extended ? 0 != (flags & overlap_mask) : 12 == batch.classification[index];
+		}
+
+		auto const convert = [&](auto const &values, auto &result, double scale, double offset) {
+			for (std::size_t index = 0; index < batch.size; ++index)
+				result[index] = offset + scale * values[index];
+		};
+		convert(coordinates[0], batch.x, x_scale, x_offset);
+		convert(coordinates[1], batch.y, y_scale, y_offset);
+		convert(coordinates[2], batch.z, z_scale, z_offset);
 	}
 
 public:
 	std::size_t size;
+	Bounds bounds;
 	OptionalSRS srs;
 
-	LAS(std::istream &input) :
+	LAS(Input &input) :
 		input(input),
 		lazperf_callback([&](unsigned char *buffer, std::size_t length) {
-			input.read(reinterpret_cast<char *>(buffer), length);
+			auto const count = std::min(length, chunk_header.size() - chunk_header_position);
+			std::memcpy(buffer, chunk_header.data() + chunk_header_position, count);
+			chunk_header_position += count;
+			input.read(reinterpret_cast<char *>(buffer) + count, length - count);
 		}),
 		chunk_size(0),
+		chunk_header_position(0),
 		point_reader(std::in_place_type<LASPointReader>, *this)
 	{
 		read_ahead(20, version_major, version_minor);
 		read_ahead(68, header_size, offset_to_point_data, number_of_variable_length_records, point_data_record_format, point_data_record_length, legacy_number_of_point_records);
-		read_ahead(20, x_scale, y_scale, z_scale, x_offset, y_offset, z_offset);
+		read_ahead(20, x_scale, y_scale, z_scale, x_offset, y_offset, z_offset, max_x, min_x, max_y, min_y);
 
 		bool const compressed = point_data_record_format & 0b10000000;
 		point_data_record_format &= 0b01111111;
@@ -286,13 +396,21 @@ public:
 			extra_bytes = point_data_record_length - minimum_length;
 		point_data_record.resize(point_data_record_length);
 
+		for (auto &values: coordinates)
+			values.resize(Batch::capacity);
+
 		if (version_minor < 4)
 			size = legacy_number_of_point_records;
 		else {
-			read_ahead(56, start_of_extended_variable_length_records, number_of_extended_variable_length_records, number_of_point_records);
+			read_ahead(24, start_of_extended_variable_length_records, number_of_extended_variable_length_records, number_of_point_records);
 			size = number_of_point_records;
 		}
 
+		if (size > 0 && std::isfinite(min_x) && std::isfinite(max_x) && std::isfinite(min_y) && std::isfinite(max_y) && min_x <= max_x && min_y <= max_y) {
+			bounds.xmin = min_x, bounds.xmax = max_x;
+			bounds.ymin = min_y, bounds.ymax = max_y;
+		}
+
 		seek_to(header_size);
 		read_vlrs<std::uint16_t>(number_of_variable_length_records);
 
@@ -314,52 +432,60 @@ public:
 			case 1: point_reader.emplace<LAZPointReader1>(*this); break;
 			case 2: point_reader.emplace<LAZPointReader2>(*this); break;
 			case 3: point_reader.emplace<LAZPointReader3>(*this); break;
-			case 6: point_reader.emplace<LAZPointReader6>(*this); break;
-			case 7: point_reader.emplace<LAZPointReader7>(*this); break;
-			case 8: point_reader.emplace<LAZPointReader8>(*this); break;
+			case 6:
+			case 7:
+			case 8: point_reader.emplace<LAZPointReader6>(*this); break;
 			}
 	}
 
-	auto read() {
-		auto const buffer = point_data_record.data();
-		read_point_record(buffer);
+	auto chunks() const {
+		return chunk_offsets.empty() ? 1 : chunk_points.size() - 1;
+	}
+
+	void prune(double resolution) {
+		if (!copc_spacing || chunk_offsets.empty())
+			return;
 
-		if constexpr (std::endian::native == std::endian::big) {
-			std::reverse(buffer,     buffer + 4);
-			std::reverse(buffer + 4, buffer + 8);
-			std::reverse(buffer + 8, buffer + 12);
-		}
-		double x = x_offset + x_scale * *reinterpret_cast<std::int32_t *>(buffer);
-		double y = y_offset + y_scale * *reinterpret_cast<std::int32_t *>(buffer + 4);
-		double z = z_offset + z_scale * *reinterpret_cast<std::int32_t *>(buffer + 8);
-
-		unsigned char classification;
-		bool key_point, withheld, overlap;
-
-		switch (point_data_record_format) {
-		case 0:
-		case 1:
-		case 2:
-		case 3:
-		case 4:
-		case 5:
-			key_point      = *reinterpret_cast<std::uint8_t *>(buffer + 15) & 0b01000000;
-			withheld       = *reinterpret_cast<std::uint8_t *>(buffer + 15) & 0b10000000;
-			classification = *reinterpret_cast<std::uint8_t *>(buffer + 15) & 0b00011111;
-			overlap        = 12 == classification;
-			break;
-		case 6:
-		case 7:
-		case 8:
-		case 9:
-		case 10:
-		default:
-			key_point      = *reinterpret_cast<std::uint8_t *>(buffer + 15) & 0b00000010;
-			withheld       = *reinterpret_cast<std::uint8_t *>(buffer + 15) & 0b00000100;
-			overlap        = *reinterpret_cast<std::uint8_t *>(buffer + 15) & 0b00001000;
-			classification = *reinterpret_cast<std::uint8_t *>(buffer + 16);
+		auto nodes = Nodes();
+		read_hierarchy(root_hierarchy_offset, root_hierarchy_size, resolution, nodes);
+		std::sort(nodes.begin(), nodes.end());
+		assign(nodes);
+	}
+
+	template <typename Intervals>
+	void select(Intervals const &intervals) {
+		if (copc_spacing || chunk_offsets.empty())
+			return;
+
+		auto nodes = Nodes();
+		auto interval = intervals.begin();
+		for (std::size_t chunk = 1, begin = 0; chunk < chunk_points.size(); begin += chunk_points[chunk++]) {
+			auto const end = begin + chunk_points[chunk];
+			while (interval != intervals.end() && interval->second <= begin)
+				++interval;
+			if (interval != intervals.end() && interval->first < end)
+				nodes.emplace_back(chunk_offsets[chunk - 1], chunk_points[chunk]);
 		}
-		return Point(x, y, z, classification, key_point, withheld, overlap);
+		assign(nodes);
+	}
+
+	void chunks(std::size_t first, std::size_t last) {
+		if (chunk_offsets.empty())
+			return;
+		chunk_points.erase(chunk_points.begin() + 1 + last, chunk_points.end());
+		chunk_points.erase(chunk_points.begin() + 1, chunk_points.begin() + 1 + first);
+		chunk_offsets.erase(chunk_offsets.begin() + last, chunk_offsets.end());
+		chunk_offsets.erase(chunk_offsets.begin(), chunk_offsets.begin() + first);
+		size = std::accumulate(chunk_points.begin(), chunk_points.end(), std::size_t(0));
+	}
+
+	void read(Batch &batch) {
+		std::visit([&](auto &point_reader) {
+			if (point_data_record_format < 6)
+				read<false>(point_reader, batch);
+			else
+				read<true>(point_reader, batch);
+		}, point_reader);
 	}
 };
 
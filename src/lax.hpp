@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LAX_HPP
+#define LAX_HPP
+
+#include "input.hpp"
+#include "bounds.hpp"
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+class LAX {
+	Input &input;
+
+	template <typename ...Args>
+	void read_values(Args &...args) {
+		(input.read(args), ...);
+	}
+
+	void read_signature(std::array<char, 4> const &expected) {
+		std::array<char, 4> signature;
+		input.read(signature.data(), signature.size());
+		if (signature != expected)
+			throw std::runtime_error("invalid LAX file");
+	}
+
+public:
+	using Intervals = std::vector<std::pair<std::uint64_t, std::uint64_t>>;
+
+	Intervals intervals;
+
+	LAX(Input &input, Bounds const &bounds) : input(input) {
+		std::uint32_t index_version, type, quadtree_version, levels, level_index, implicit_levels, interval_version;
+		float min_x, max_x, min_y, max_y;
+		std::int32_t number_cells;
+
+		read_signature({'L','A','S','X'});
+		read_values(index_version);
+		read_signature({'L','A','S','S'});
+		read_values(type, quadtree_version, levels, level_index, implicit_levels, min_x, max_x, min_y, max_y);
+		read_signature({'L','A','S','V'});
+		read_values(interval_version, number_cells);
+
+		if (type != 0 || number_cells < 0)
+			throw std::runtime_error("invalid LAX file");
+
+		for (; number_cells > 0; --number_cells) {
+			std::int32_t cell_index;
+			std::uint32_t number_intervals, number_points;
+			read_values(cell_index, number_intervals, number_points);
+			if (cell_index < 0)
+				throw std::runtime_error("invalid LAX file");
+
+			auto level = 0u;
+			auto cell = static_cast<std::uint64_t>(cell_index);
+			for (; cell >= 1ull << 2 * level; ++level)
+				cell -= 1ull << 2 * level;
+
+			auto cell_bounds = Bounds();
+			cell_bounds.xmin = min_x, cell_bounds.xmax = max_x;
+			cell_bounds.ymin = min_y, cell_bounds.ymax = max_y;
+			for (; level > 0; --level) {
+				auto const quadrant = cell >> 2 * (level - 1) & 3;
+				auto const x = (cell_bounds.xmin + cell_bounds.xmax) / 2;
+				auto const y = (cell_bounds.ymin + cell_bounds.ymax) / 2;
+				(quadrant & 1 ? cell_bounds.xmin : cell_bounds.xmax) = x;
+				(quadrant & 2 ? cell_bounds.ymin : cell_bounds.ymax) = y;
+			}
+
+			for (; number_intervals > 0; --number_intervals) {
+				std::uint32_t start, end;
+				read_values(start, end);
+				if (end < start)
+					throw std::runtime_error("invalid LAX file");
+				if (cell_bounds & bounds)
+					intervals.emplace_back(start, end + 1ull);
+			}
+		}
+
+		std::sort(intervals.begin(), intervals.end());
+	}
+};
+
+#endif
@@ -6,6 +6,8 @@
 
 #include "app.hpp"
 #include "output.hpp"
+#include "stream.hpp"
+#include "tiles.hpp"
 #include "defaults.hpp"
 #include "points.hpp"
 #include "mesh.hpp"
@@ -19,8 +21,10 @@ int main(int argc, char *argv[]) {
 	try {
 		auto app = App(argc, argv);
 		{ auto output = Output(app); }
-		{ auto defaults = Defaults(app); }
-		auto points = Points(app);
+		auto stream = Stream(app);
+		auto tiles = Tiles(app, stream.scans);
+		auto defaults = Defaults(app, tiles);
+		auto points = Points(app, tiles, app.stream ? stream.decoded : defaults.decoded);
 		auto mesh = Mesh(app, points);
 		auto edges = Edges(app, mesh);
 		auto polygons = Polygons(app, edges);
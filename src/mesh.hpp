@@ -13,90 +13,242 @@
 #include "circle.hpp"
 #include "triangles.hpp"
 #include "triangle.hpp"
-#include "rtree.hpp"
+#include "histogram.hpp"
 #include "app.hpp"
+#include "radix.hpp"
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
 #include <optional>
 #include <thread>
-#include <optional>
+#include <limits>
+#include <bit>
+#include <numeric>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+class Mesh {
+	using Index = std::uint32_t;
+	using Indices = std::vector<Index>;
+	using Flags = std::vector<unsigned char>;
+
+	Index static constexpr none = std::numeric_limits<Index>::max();
+
+	struct Block {
+		Index *spare;
+		std::size_t count;
+	};
 
-class Mesh : std::vector<std::vector<PointIterator>> {
 	Points &points;
+	Indices targets, nexts, prevs, outgoing, spare;
+	Flags removed;
+
+	auto static morton(Point const &point) {
+		auto const spread = [](std::uint64_t value) {
+			value = (value | value << 16) & 0x0000ffff0000ffff;
+			value = (value | value <<  8) & 0x00ff00ff00ff00ff;
+			value = (value | value <<  4) & 0x0f0f0f0f0f0f0f0f;
+			value = (value | value <<  2) & 0x3333333333333333;
+			value = (value | value <<  1) & 0x5555555555555555;
+			return value;
+		};
+		auto const x = static_cast<std::uint32_t>(point.x) ^ 0x80000000u;
+		auto const y = static_cast<std::uint32_t>(point.y) ^ 0x80000000u;
+		return spread(x) << 1 | spread(y);
+	}
 
-	auto &adjacent(PointIterator point) {
-		return (*this)[point - points.begin()];
+	template <typename Function>
+	void static parallel(std::size_t size, int threads, Function const &function) {
+		auto workers = std::vector<std::thread>();
+		for (int thread = 1; thread < threads; ++thread)
+			workers.emplace_back(function, size * thread / threads, size * (thread + 1) / threads);
+		function(std::size_t(0), size / threads);
+		for (auto &worker: workers)
+			worker.join();
 	}
 
-	auto &adjacent(PointIterator point) const {
-		return (*this)[point - points.begin()];
+	auto keys(int threads) const {
+		auto keys = std::vector<std::uint64_t>(points.size());
+		parallel(points.size(), threads, [&](auto begin, auto end) {
+			for (auto index = begin; index < end; ++index)
+				keys[index] = morton(points[index]);
+		});
+		return keys;
 	}
 
-	void connect(PointIterator p1, PointIterator p2) {
-		adjacent(p1).push_back(p2);
-		adjacent(p2).push_back(p1);
+	void reorder(int threads) {
+		auto keys = this->keys(threads);
+		radix_sort(keys, static_cast<std::vector<Point> &>(points), threads);
 	}
 
-	void disconnect(Edge const &edge) {
-		auto &neighbours = adjacent(edge.first);
-		neighbours.erase(std::find(neighbours.begin(), neighbours.end(), edge.second));
+	void renumber(int threads) {
+		auto order = Indices(points.size());
+		std::iota(order.begin(), order.end(), 0);
+		{
+			auto keys = this->keys(threads);
+			radix_sort(keys, order, threads);
+		}
+		{
+			auto positions = Indices(points.size());
+			parallel(points.size(), threads, [&](auto begin, auto end) {
+				for (auto index = begin; index < end; ++index)
+					positions[order[index]] = index;
+			});
+			parallel(targets.size(), threads, [&](auto begin, auto end) {
+				for (auto half = begin; half < end; ++half)
+					targets[half] = positions[targets[half]];
+			});
+		}
+		for (Index index = 0; index < order.size(); ++index) {
+			if (order[index] == index)
+				continue;
+			auto const point = points[index];
+			auto const half = outgoing[index];
+			auto here = index;
+			for (auto there = order[here]; there != index; here = there, there = order[here]) {
+				points[here] = points[there];
+				outgoing[here] = outgoing[there];
+				order[here] = here;
+			}
+			points[here] = point;
+			outgoing[here] = half;
+			order[here] = here;
+		}
 	}
 
-	void disconnect(PointIterator p1, PointIterator p2) {
-		disconnect({p1, p2});
-		disconnect({p2, p1});
+	auto index(PointIterator point) const {
+		return static_cast<Index>(point - points.begin());
 	}
 
-	auto static less_than(Edge const &edge, PointIterator p1, PointIterator p2) {
-		return edge < p1
-			? edge > p2 || Edge(p1, p2) > edge.second
-			: edge > p2 && Edge(p1, p2) > edge.second;
+	auto origin(Index half) const {
+		return targets[half ^ 1];
 	}
 
-	auto next_interior(Edge const &edge) {
-		auto const &neighbours = adjacent(edge.second);
-		auto const next = std::max_element(neighbours.begin(), neighbours.end(), [&](auto const &p1, auto const &p2) {
-			return p1 == edge.first ? true : p2 == edge.first ? false : less_than(edge, p1, p2);
-		});
-		if (next == neighbours.end())
-			throw std::runtime_error("unexpected");
-		return Edge(edge.second, *next);
+	auto target(Index half) const {
+		return points.begin() + targets[half];
 	}
 
-	auto next_exterior(Edge const &edge) {
-		auto const &neighbours = adjacent(edge.second);
-		auto const next = std::min_element(neighbours.begin(), neighbours.end(), [&](auto const &p1, auto const &p2) {
-			return p1 == edge.first ? false : p2 == edge.first ? true : less_than(edge, p1, p2);
-		});
-		if (next == neighbours.end())
-			throw std::runtime_error("unexpected");
-		return Edge(edge.second, *next);
+	auto as_edge(Index half) const {
+		return Edge(points.begin() + origin(half), points.begin() + targets[half]);
+	}
+
+	auto between(Index half1, Index half2, Index half) const {
+		auto const point = points.begin() + origin(half);
+		auto const p1 = points.begin() + targets[half1];
+		auto const p2 = points.begin() + targets[half2];
+		auto const p = points.begin() + targets[half];
+		auto const left1 = Edge(point, p1) > p, left2 = Edge(point, p) > p2;
+		return Edge(point, p1) > p2 ? left1 && left2 : left1 || left2;
+	}
+
+	void insert(Index half) {
+		auto &first = outgoing[origin(half)];
+		if (first == none) {
+			nexts[half] = prevs[half] = first = half;
+			return;
+		}
+		auto around = first;
+		while (nexts[around] != first && !between(around, nexts[around], half))
+			around = nexts[around];
+		nexts[half] = nexts[around], prevs[half] = around;
+		prevs[nexts[around]] = half, nexts[around] = half;
+	}
+
+	void erase(Index half) {
+		auto &first = outgoing[origin(half)];
+		if (nexts[half] == half)
+			first = none;
+		else {
+			nexts[prevs[half]] = nexts[half], prevs[nexts[half]] = prevs[half];
+			if (first == half)
+				first = nexts[half];
+		}
+	}
+
+	void connect(PointIterator p1, PointIterator p2, Block &block) {
+		auto const half = block.spare[--block.count] << 1;
+		targets[half] = index(p2), targets[half ^ 1] = index(p1);
+		removed[half] = removed[half ^ 1] = false;
+		insert(half), insert(half ^ 1);
+	}
+
+	void disconnect(Index half, Block &block) {
+		erase(half), erase(half ^ 1);
+		block.spare[block.count++] = half >> 1;
+	}
+
+	void disconnect(Index half) {
+		removed[half] = true;
+	}
+
+	template <typename Function>
+	void each_outgoing(PointIterator point, Function const &function) const {
+		if (auto const first = outgoing[index(point)]; first != none)
+			for (auto half = first; ; ) {
+				auto const next = nexts[half];
+				if (!removed[half])
+					function(half);
+				if ((half = next) == first)
+					break;
+			}
+	}
+
+	auto next_interior(Index half) const {
+		for (auto next = prevs[half ^ 1]; ; next = prevs[next])
+			if (!removed[next])
+				return next;
+			else if (next == (half ^ 1))
+				throw std::runtime_error("unexpected");
+	}
+
+	auto next_exterior(Index half) const {
+		for (auto next = nexts[half ^ 1]; ; next = nexts[next])
+			if (!removed[next])
+				return next;
+			else if (next == (half ^ 1))
+				throw std::runtime_error("unexpected");
+	}
+
+	auto following(Index half) const {
+		return prevs[half ^ 1];
+	}
+
+	auto preceding(Index half) const {
+		return nexts[half] ^ 1;
+	}
+
+	auto bounded(Index half) const {
+		auto const next = following(half);
+		return following(following(next)) == half && as_edge(half) > target(next);
 	}
 
 	struct Iterator {
 		Mesh &mesh;
-		Edge edge;
+		Index half;
 		bool interior;
+		Edge edge;
 
-		Iterator(Mesh &mesh, Edge edge, bool interior) :
+		Iterator(Mesh &mesh, Index half, bool interior) :
 			mesh(mesh),
-			edge(edge),
-			interior(interior)
+			half(half),
+			interior(interior),
+			edge(mesh.as_edge(half))
 		{ }
 
 		auto peek() const {
-			return interior ? mesh.next_interior(edge) : mesh.next_exterior(edge);
+			return interior ? mesh.next_interior(half) : mesh.next_exterior(half);
 		}
 
 		auto &operator++() {
-			edge = peek();
+			half = peek();
+			edge = mesh.as_edge(half);
 			return *this;
 		}
 
 		auto &reverse() {
 			interior = !interior;
+			half ^= 1;
 			edge = -edge;
 			return *this;
 		}
@@ -115,19 +267,21 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 	};
 
 	auto exterior_clockwise(PointIterator rightmost) {
-		auto const &neighbours = adjacent(rightmost);
-		auto const next = std::min_element(neighbours.begin(), neighbours.end(), [&](auto const &p1, auto const &p2) {
-			return Edge(p1, p2) < rightmost;
+		auto next = none;
+		each_outgoing(rightmost, [&](auto half) {
+			if (next == none || Edge(points.begin() + targets[half], points.begin() + targets[next]) < rightmost)
+				next = half;
 		});
-		return Iterator(*this, Edge(rightmost, *next), true);
+		return Iterator(*this, next, true);
 	}
 
 	auto exterior_anticlockwise(PointIterator leftmost) {
-		auto const &neighbours = adjacent(leftmost);
-		auto const next = std::max_element(neighbours.begin(), neighbours.end(), [&](auto const &p1, auto const &p2) {
-			return Edge(p1, p2) < leftmost;
+		auto next = none;
+		each_outgoing(leftmost, [&](auto half) {
+			if (next == none || Edge(points.begin() + targets[next], points.begin() + targets[half]) < leftmost)
+				next = half;
 		});
-		return Iterator(*this, Edge(leftmost, *next), false);
+		return Iterator(*this, next, false);
 	}
 
 	auto exterior_clockwise(PointIterator begin, PointIterator end) {
@@ -141,10 +295,11 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 	}
 
 	template <bool rhs>
-	auto find_candidate(Iterator const &edge, PointIterator opposite) {
+	auto find_candidate(Iterator const &edge, PointIterator opposite, Block &block) {
 		auto const &[prev, point] = *edge;
 		while (true) {
-			auto const [candidate, next] = edge.search();
+			auto const half = edge.peek();
+			auto const [candidate, next] = as_edge(edge.search());
 			auto const orientation = Edge(point, candidate) <=> opposite;
 			if (rhs ? orientation <= 0 : orientation >= 0)
 				return std::optional<PointIterator>();
@@ -152,20 +307,38 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 				return std::optional<PointIterator>(candidate);
 			if (Circle(rhs ? candidate : point, opposite, rhs ? point : candidate) <= next)
 				return std::optional<PointIterator>(candidate);
-			disconnect(point, candidate);
+			disconnect(half, block);
 		}
 	}
 
 	template <bool horizontal = true>
-	void triangulate(PointIterator begin, PointIterator end, int threads) {
+	std::size_t triangulate(PointIterator begin, PointIterator end, int threads, bool ordered = false) {
 		auto static constexpr less_than = [](Point const &p1, Point const &p2) {
 			if constexpr (horizontal)
 				return p1[0] < p2[0] ? true : p1[0] > p2[0] ? false : p1[1] < p2[1];
 			else
 				return p1[1] < p2[1] ? true : p1[1] > p2[1] ? false : p1[0] > p2[0];
 		};
-		auto const middle = begin + (end - begin) / 2;
-		std::nth_element(begin, middle, end, less_than);
+		auto middle = begin + (end - begin) / 2;
+		if (auto const bits = ordered && end - begin > 3 ? morton(*begin) ^ morton(*(end - 1)) : 0; bits != 0) {
+			auto const bit = std::bit_width(bits) - 1;
+			if ((bit & 1) != horizontal)
+				return triangulate<!horizontal>(begin, end, threads, true);
+			auto const split = std::partition_point(begin, end, [=](auto const &point) {
+				return 0 == (morton(point) >> bit & 1);
+			});
+			if (split - begin > 1 && end - split > 1)
+				middle = split;
+			else
+				ordered = false;
+		}
+		if (!ordered || end - begin < 4)
+			std::nth_element(begin, middle, end, less_than);
+
+		auto block = Block{spare.data() + 3 * index(begin), 0};
+		if (end - begin < 4)
+			for (auto pair = 3 * index(begin); pair < 3 * index(end); ++pair)
+				block.spare[block.count++] = pair;
 
 		switch (end - begin) {
 		case 0:
@@ -173,24 +346,27 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 			break;
 		case 3:
 			if (Edge(begin+2, begin+1) <=> begin != 0)
-				connect(begin, begin+2);
-			connect(begin+2, begin+1);
+				connect(begin, begin+2, block);
+			connect(begin+2, begin+1, block);
 			[[fallthrough]];
 		case 2:
-			connect(begin+1, begin);
+			connect(begin+1, begin, block);
 			break;
 		default:
+			auto left_count = std::size_t(), right_count = std::size_t();
 			if (threads > 1) {
 				auto left_thread = std::thread([&]() {
-					triangulate<!horizontal>(begin, middle, threads/2);
+					left_count = triangulate<!horizontal>(begin, middle, threads/2, ordered);
 				}), right_thread = std::thread([&]() {
-					triangulate<!horizontal>(middle, end, threads - threads/2);
+					right_count = triangulate<!horizontal>(middle, end, threads - threads/2, ordered);
 				});
 				left_thread.join(), right_thread.join();
 			} else {
-				triangulate<!horizontal>(begin, middle, 1);
-				triangulate<!horizontal>(middle, end, 1);
+				left_count = triangulate<!horizontal>(begin, middle, 1, ordered);
+				right_count = triangulate<!horizontal>(middle, end, 1, ordered);
 			}
+			auto const right_spare = spare.data() + 3 * index(middle);
+			block.count = std::copy(right_spare, right_spare + right_count, block.spare + left_count) - block.spare;
 			auto const rightmost = std::max_element(begin, middle, less_than);
 			auto const leftmost = std::min_element(middle, end, less_than);
 			auto left = exterior_clockwise(rightmost);
@@ -210,8 +386,8 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 				auto const &left_point = left->second;
 				auto const &right_point = right->second;
 				pairs.emplace_back(left_point, right_point);
-				auto const left_candidate = find_candidate<false>(left, right_point);
-				auto const right_candidate = find_candidate<true>(right, left_point);
+				auto const left_candidate = find_candidate<false>(left, right_point, block);
+				auto const right_candidate = find_candidate<true>(right, left_point, block);
 				if (left_candidate && right_candidate)
 					Circle(left_point, right_point, *right_candidate) > *left_candidate ? ++left : ++right;
 				else if (left_candidate)
@@ -222,41 +398,58 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 					break;
 			}
 			for (auto const &[p1, p2]: pairs)
-				connect(p1, p2);
+				connect(p1, p2, block);
 		}
+		return block.count;
 	}
 
-	void deconstruct(Triangles &triangles, PointIterator begin, PointIterator end, double width, bool anticlockwise, int threads) {
+	void deconstruct(Triangles &triangles, Indices &boundary, PointIterator begin, PointIterator end, double width, bool anticlockwise, int threads) {
+		auto const visit = [&](PointIterator point) {
+			auto outside = false;
+			each_outgoing(point, [&](auto half) {
+				auto const edge1 = Iterator(*this, half, anticlockwise);
+				if (edge1->second < begin || !(edge1->second < end)) {
+					outside = true;
+					return;
+				}
+				auto const edge2 = Iterator(*this, edge1.peek(), anticlockwise);
+				if (edge2->second < begin || !(edge2->second < end))
+					return;
+				auto const edge3 = Iterator(*this, edge2.peek(), anticlockwise);
+				if (edge3->second != point)
+					throw std::runtime_error("corrupted mesh");
+				auto const triangle = Triangle{{*edge1, *edge2, *edge3}};
+				if (triangle > width)
+					triangles.insert(triangle);
+				disconnect(edge1.half);
+				disconnect(edge2.half);
+				disconnect(edge3.half);
+			});
+			if (outside)
+				boundary.push_back(index(point));
+		};
+
 		if (threads > 1) {
 			auto const middle = begin + (end - begin) / 2;
 			auto left_triangles = Triangles();
 			auto right_triangles = Triangles();
+			auto left_boundary = Indices();
+			auto right_boundary = Indices();
 			auto left_thread = std::thread([&]() {
-				deconstruct(left_triangles, begin, middle, width, anticlockwise, threads/2);
+				deconstruct(left_triangles, left_boundary, begin, middle, width, anticlockwise, threads/2);
 			}), right_thread = std::thread([&]() {
-				deconstruct(right_triangles, middle, end, width, anticlockwise, threads - threads/2);
+				deconstruct(right_triangles, right_boundary, middle, end, width, anticlockwise, threads - threads/2);
 			});
 			left_thread.join(), right_thread.join();
 			triangles.merge(left_triangles);
 			triangles.merge(right_triangles);
-		}
-		for (auto point = begin; point < end; ++point)
-			for (auto const neighbours = adjacent(point); auto const &neighbour: neighbours) {
-				auto const edge1 = Iterator(*this, Edge(point, neighbour), anticlockwise);
-				if (edge1->second < begin || !(edge1->second < end))
-					continue;
-				auto const edge2 = Iterator(*this, edge1.peek(), anticlockwise);
-				if (edge2->second < begin || !(edge2->second < end))
-					continue;
-				auto const edge3 = Iterator(*this, edge2.peek(), anticlockwise);
-				if (edge3->second != point)
-					throw std::runtime_error("corrupted mesh");
-				auto const triangle = Triangle{{*edge1, *edge2, *edge3}};
-				if (triangle > width)
-					triangles.insert(triangle);
-				for (auto const &edge: triangle)
-					disconnect(edge);
-			}
+			for (auto const point: left_boundary)
+				visit(points.begin() + point);
+			for (auto const point: right_boundary)
+				visit(points.begin() + point);
+		} else
+			for (auto point = begin; point < end; ++point)
+				visit(point);
 	}
 
 	template <typename ...Functions>
@@ -266,85 +459,201 @@ class Mesh : std::vector<std::vector<PointIterator>> {
 		auto const start = anticlockwise ? exterior_clockwise(begin, end) : exterior_anticlockwise(begin, end);
 		for (auto edge = start; ; ++edge) {
 			(functions(*edge), ...);
-			disconnect(*edge);
+			disconnect(edge.half);
 			if (edge->second == start->first)
 				break;
 		}
 	}
 
-	using RTree = ::RTree<PointIterator>;
+	auto face(PointIterator begin, PointIterator end) const {
+		for (auto point = begin; point < end; ++point)
+			if (auto const first = outgoing[index(point)]; first != none)
+				for (auto half = first; ; ) {
+					if (bounded(half))
+						return half;
+					if ((half = nexts[half]) == first)
+						break;
+				}
+		return none;
+	}
 
-	void interpolate(PointIterator begin, PointIterator end, RTree const &rtree, int threads) {
-		if (threads > 1) {
-			auto const middle = begin + (end - begin) / 2;
-			auto left_thread = std::thread([&]() {
-				interpolate(begin, middle, rtree, threads/2);
-			}), right_thread = std::thread([&]() {
-				interpolate(middle, end, rtree, threads - threads/2);
-			});
-			left_thread.join(), right_thread.join();
+	template <typename Predicate>
+	auto curve(Predicate const &predicate, int threads) const {
+		auto keys = std::vector<std::uint64_t>();
+		auto order = Indices();
+		for (auto point = points.begin(); point < points.end(); ++point)
+			if (predicate(point))
+				keys.push_back(morton(*point)), order.push_back(index(point));
+		radix_sort(keys, order, threads);
+		return order;
+	}
+
+	auto locate(PointIterator point, Index half) const {
+		for (auto count = 0; count < 3; ) {
+			if (as_edge(half) < point) {
+				if (!bounded(half ^= 1))
+					return half;
+				count = 1;
+			} else
+				++count;
+			half = following(half);
 		}
-		for (auto point = begin; point < end; ++point)
-			for (auto const neighbours = adjacent(point); auto const &neighbour: neighbours) {
-				auto const edge1 = Iterator(*this, Edge(point, neighbour), true);
-				if (edge1->second < begin || !(edge1->second < end))
-					continue;
-				auto const edge2 = Iterator(*this, edge1.peek(), true);
-				if (edge2->second < begin || !(edge2->second < end))
+		return half;
+	}
+
+	void interpolate(PointIterator ground_end, Index start, int threads) {
+		auto const order = curve([&](auto point) {
+			return !(point < ground_end);
+		}, threads);
+		parallel(order.size(), threads, [&](auto begin, auto end) {
+			for (auto half = start; begin < end; ++begin) {
+				auto const point = points.begin() + order[begin];
+				if (half = locate(point, half); !bounded(half)) {
+					half ^= 1;
 					continue;
-				auto const edge3 = Iterator(*this, edge2.peek(), true);
-				if (edge3->second != point)
-					throw std::runtime_error("corrupted mesh");
-				auto const &p1 = edge1->first;
-				auto const &p2 = edge2->first;
-				auto const &p3 = edge3->first;
-				auto const bounds = Bounds(p1) + Bounds(p2) + Bounds(p3);
-				for (auto const &point: rtree.search(bounds)) {
-					auto const w1 = (*edge2 ^ point) / (*edge2 ^ p1);
-					auto const w2 = (*edge3 ^ point) / (*edge3 ^ p2);
-					auto const w3 = (*edge1 ^ point) / (*edge1 ^ p3);
-					if (w1 >= 0 && w2 >= 0 && w3 >= 0)
-						point->ground(w1 * p1->elevation + w2 * p2->elevation + w3 * p3->elevation);
 				}
-				disconnect(*edge1);
-				disconnect(*edge2);
-				disconnect(*edge3);
+				auto const edge1 = as_edge(half), edge2 = as_edge(following(half)), edge3 = as_edge(following(following(half)));
+				auto const &p1 = edge1.first;
+				auto const &p2 = edge2.first;
+				auto const &p3 = edge3.first;
+				auto const w1 = (edge2 ^ point) / (edge2 ^ p1);
+				auto const w2 = (edge3 ^ point) / (edge3 ^ p2);
+				auto const w3 = (edge1 ^ point) / (edge1 ^ p3);
+				point->ground(w1 * p1->elevation + w2 * p2->elevation + w3 * p3->elevation);
 			}
+		});
 	}
 
-	void interpolate(PointIterator ground_begin, PointIterator ground_end, int threads) {
-		auto const rtree = RTree(ground_end, points.end(), threads);
-		strip_exterior(ground_begin, ground_end, true);
-		interpolate(ground_begin, ground_end, rtree, threads);
+	void legalise(PointIterator point, Indices &stack, Block &block) {
+		while (!stack.empty()) {
+			auto const half = stack.back();
+			stack.pop_back();
+			if (!bounded(half ^ 1))
+				continue;
+			auto const half1 = following(half ^ 1), half2 = following(half1);
+			auto const &[p1, p2] = as_edge(half);
+			if (Circle(p1, p2, point) > target(half1)) {
+				disconnect(half, block);
+				connect(point, target(half1), block);
+				stack.push_back(half1), stack.push_back(half2);
+			}
+		}
+	}
+
+	auto add(PointIterator point, Index start, Indices &stack, Block &block) {
+		auto const half = locate(point, start);
+		if (!bounded(half)) {
+			auto first = half, last = half;
+			while (as_edge(preceding(first)) > point)
+				first = preceding(first);
+			while (as_edge(following(last)) > point)
+				last = following(last);
+			connect(point, points.begin() + origin(first), block);
+			for (auto edge = first; ; edge = following(edge)) {
+				stack.push_back(edge);
+				if (edge == last)
+					break;
+			}
+			for (auto const edge: stack)
+				connect(point, target(edge), block);
+		} else {
+			auto const halves = {half, following(half), following(following(half))};
+			auto const colinear = std::find_if(halves.begin(), halves.end(), [&](auto edge) {
+				return (as_edge(edge) <=> point) == 0;
+			});
+			if (colinear == halves.end()) {
+				for (auto const edge: halves)
+					connect(point, target(edge), block), stack.push_back(edge);
+			} else {
+				auto const edge = *colinear, next = following(edge);
+				if ((as_edge(next) <=> point) == 0 || (as_edge(following(next)) <=> point) == 0)
+					return start;
+				auto const [p1, p2] = as_edge(edge);
+				stack.push_back(next), stack.push_back(following(next));
+				if (auto const twin = edge ^ 1; bounded(twin))
+					stack.push_back(following(twin)), stack.push_back(following(following(twin)));
+				disconnect(edge, block);
+				connect(point, p1, block), connect(point, p2, block);
+				for (auto other = stack.begin(); other < stack.end(); other += 2)
+					connect(point, target(*other), block);
+			}
+		}
+		legalise(point, stack, block);
+		auto next = outgoing[index(point)];
+		while (!bounded(next))
+			next = nexts[next];
+		return next;
+	}
+
+	void insert(PointIterator ground_begin, PointIterator ground_end, std::size_t count, Index start, int threads) {
+		auto const ground = std::size_t(3 * index(ground_begin)) + count;
+		auto const pairs = 3 * points.size() - 3 * index(ground_end);
+		std::iota(spare.begin(), spare.begin() + 3 * index(ground_begin), 0);
+		std::iota(spare.begin() + ground, spare.begin() + ground + pairs, 3 * index(ground_end));
+		auto block = Block{spare.data(), ground + pairs};
+
+		auto const order = curve([&](auto point) {
+			return point < ground_begin || !(point < ground_end);
+		}, threads);
+		auto stack = Indices();
+		for (auto const point: order)
+			start = add(points.begin() + point, start, stack, block);
+		renumber(threads);
 	}
 
-public:
 	Mesh(Points &points) :
-		vector(points.size()),
 		points(points)
 	{
-		triangulate(points.begin(), points.end(), 1);
+		static_assert(Points::max_size <= none / 6);
+		if (points.size() > Points::max_size)
+			throw std::runtime_error("too many points, increase --width");
+		targets.resize(6 * points.size());
+		nexts.resize(6 * points.size());
+		prevs.resize(6 * points.size());
+		removed.resize(6 * points.size());
+		outgoing.resize(points.size(), none);
+		spare.resize(3 * points.size());
 	}
 
-	Mesh(App const &app, Points &points) :
-		vector(points.size()),
-		points(points)
-	{
-		auto const ground_begin = std::partition(points.begin(), points.end(), [](auto const &point) {
+public:
+	template <typename Patches>
+	Mesh(Points &points, Patches const &patches) : Mesh(points) {
+		for (auto const &[begin, end]: patches)
+			triangulate(begin, end, 1);
+	}
+
+	Mesh(App const &app, Points &points) : Mesh(points) {
+		auto const partition = [&](auto begin, auto const &predicate) {
+			return app.reorder ? std::stable_partition(begin, points.end(), predicate) : std::partition(begin, points.end(), predicate);
+		};
+
+		if (app.reorder)
+			reorder(app.threads);
+		auto const ground_begin = partition(points.begin(), [](auto const &point) {
 			return point.synthetic();
 		});
-		auto const ground_end = std::partition(ground_begin, points.end(), [](auto const &point) {
+		auto const ground_end = partition(ground_begin, [](auto const &point) {
 			return point.ground();
 		});
 
 		app.log("triangulating", ground_end - ground_begin, "point");
-		triangulate(ground_begin, ground_end, app.threads);
+		auto const count = triangulate(ground_begin, ground_end, app.threads, app.reorder);
+		if (ground_end - ground_begin < 2)
+			throw std::runtime_error("not enough points");
 
 		app.log("interpolating", points.end() - ground_end, "point");
-		interpolate(ground_begin, ground_end, app.threads);
+		if (auto const start = face(ground_begin, ground_end); start != none) {
+			interpolate(ground_end, start, app.threads);
+			app.log("inserting", points.size() - (ground_end - ground_begin), "point");
+			insert(ground_begin, ground_end, count, start, app.threads);
+			return;
+		}
 
 		app.log("triangulating", points.size(), "point");
-		triangulate(points.begin(), points.end(), app.threads);
+		std::fill(outgoing.begin(), outgoing.end(), none);
+		if (app.reorder)
+			reorder(app.threads);
+		triangulate(points.begin(), points.end(), app.threads, app.reorder);
 	}
 
 	template <typename Edges>
@@ -352,24 +661,17 @@ public:
 		strip_exterior(points.begin(), points.end(), app.land, [&](auto const &edge) {
 			edges.insert(-edge);
 		});
-		deconstruct(triangles, points.begin(), points.end(), *app.width, app.land, app.threads);
+		auto boundary = Indices();
+		deconstruct(triangles, boundary, points.begin(), points.end(), *app.width, app.land, app.threads);
 	}
 
-	auto median_length() const {
-		auto lengths = std::vector<double>();
-		lengths.reserve(size() * 6);
-
+	auto lengths() const {
+		auto histogram = Histogram();
 		for (auto p0 = points.begin(); p0 < points.end(); ++p0)
-			for (auto const &p1: adjacent(p0))
-				lengths.push_back((*p1 - *p0).sqnorm());
-
-		auto const begin = lengths.begin(), end = lengths.end();
-		auto const median = begin + (end - begin) / 2;
-		std::nth_element(begin, median, end);
-
-		return median == end ?
-			std::optional<double>() :
-			std::optional(std::sqrt(*median));
+			each_outgoing(p0, [&](auto half) {
+				histogram.insert((points[targets[half]] - *p0).sqnorm());
+			});
+		return histogram;
 	}
 };
 
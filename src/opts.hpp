@@ -21,6 +21,7 @@
 
 struct Opts {
 	using Ints = std::vector<int>;
+	using Doubles = std::vector<double>;
 	using Path = std::filesystem::path;
 	using Paths = std::vector<Path>;
 
@@ -34,10 +35,15 @@ struct Opts {
 	std::optional<bool>   raw;
 	std::optional<bool>   multi;
 	std::optional<bool>   lines;
+	std::optional<bool>   reorder;
 	std::optional<Ints>   discard;
+	std::optional<Doubles> bounds;
 	std::optional<int>    epsg;
 	std::optional<Ints>   threads;
+	std::optional<Ints>   prefetch;
 	std::optional<Path>   tiles_path;
+	std::optional<bool>   stream;
+	std::optional<Path>   cache;
 	std::optional<bool>   overwrite;
 	std::optional<bool>   quiet;
 
@@ -61,10 +67,15 @@ struct Opts {
 		args.option("",   "--raw",                       "don't smooth output polygons",                   raw);
 		args.option("",   "--multi",                     "collect polygons into single multipolygon",      multi);
 		args.option("",   "--lines",                     "output polygon boundaries as linestrings",       lines);
+		args.option("",   "--reorder",                   "sort points spatially before triangulating",     reorder);
 		args.option("",   "--discard",    "<class,...>", "discard point classes",                          discard);
+		args.option("",   "--bounds",     "<x,y,x,y>",   "area of interest as a bounding box",             bounds);
 		args.option("",   "--epsg",       "<number>",    "override missing or incorrect EPSG codes",       epsg);
 		args.option("",   "--threads",    "<number>",    "number of processing threads",                   threads);
+		args.option("",   "--prefetch",   "<number>",    "number of tiles to read ahead",                  prefetch);
 		args.option("",   "--tiles",      "<tiles.txt>", "list of input tiles as a text file",             tiles_path);
+		args.option("",   "--stream",                    "process tiles as they arrive via --tiles -",     stream);
+		args.option("",   "--cache",      "<directory>", "directory for caching thinned tile points",      cache);
 		args.option("-o", "--overwrite",                 "overwrite existing output file",                 overwrite);
 		args.option("-q", "--quiet",                     "don't show progress information",                quiet);
 #ifdef VERSION
@@ -77,6 +88,8 @@ struct Opts {
 			if (tiles_path) {
 				if (!tile_paths.empty())
 					throw std::runtime_error("can't specify tiles as arguments and also in a file");
+				if (stream && *tiles_path == "-")
+					return;
 				if (*tiles_path == "-") {
 					std::cin.exceptions(std::ifstream::badbit);
 					for (std::string line; std::getline(std::cin, line); )
@@ -110,15 +123,31 @@ struct Opts {
 		for (auto klass: *discard)
 			if (klass < 0 || klass > 255)
 				throw std::runtime_error("invalid lidar point class " + std::to_string(klass));
+		if (bounds && bounds->size() != 4)
+			throw std::runtime_error("bounds must have four values");
+		if (bounds && ((*bounds)[0] >= (*bounds)[2] || (*bounds)[1] >= (*bounds)[3]))
+			throw std::runtime_error("invalid bounds");
 		if (threads->size() > 2)
 			throw std::runtime_error("at most two thread count values allowed");
 		for (auto count: *threads)
 			if (count < 1)
 				throw std::runtime_error("number of threads must be positive");
+		if (prefetch && prefetch->size() > 2)
+			throw std::runtime_error("at most two prefetch values allowed");
+		if (prefetch)
+			for (auto value: *prefetch)
+				if (value < 1)
+					throw std::runtime_error("prefetch values must be positive");
 		if (raw && simplify)
 			throw std::runtime_error("can't simplify raw output");
 		if (raw && scale)
 			throw std::runtime_error("can't use scale with raw output");
+		if (stream && !(tiles_path && *tiles_path == "-"))
+			throw std::runtime_error("can only stream tiles from standard input");
+		if (stream && !width)
+			throw std::runtime_error("width must be specified when streaming tiles");
+		if (cache && !std::filesystem::is_directory(*cache))
+			throw std::runtime_error("cache directory doesn't exist");
 	}
 };
 
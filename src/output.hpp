@@ -50,15 +50,15 @@ public:
 
 	Output(App const &app, Polygons const &polygons, Points const &points) : Output(app) {
 		auto const polys = polygons.reassemble(allow_self_intersection());
-		app.log("saving", polys.size(), "polygon", points.srs() ? "" : " (no SRS available)");
+		app.log("saving", polys.size(), "polygon", points.srs ? "" : " (no SRS available)");
 		if (app.multi && app.lines)
-			(*this)(polys.multilinestrings(), points.srs());
+			(*this)(polys.multilinestrings(), points.srs);
 		else if (app.lines)
-			(*this)(polys.linestrings(), points.srs());
+			(*this)(polys.linestrings(), points.srs);
 		else if (app.multi)
-			(*this)(polys.multipolygon(), points.srs());
+			(*this)(polys.multipolygon(), points.srs);
 		else
-			(*this)(polys, points.srs());
+			(*this)(polys, points.srs);
 	}
 };
 
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PACKED_HPP
+#define PACKED_HPP
+
+#include "point.hpp"
+#include <vector>
+#include <deque>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+class Packed {
+	using Block = std::vector<unsigned char>;
+	using Keys = std::vector<std::uint64_t>;
+	using Points = std::vector<Point>;
+
+	std::size_t static constexpr block_points = 4096;
+
+	std::deque<Block> blocks;
+	std::size_t remaining, position;
+	std::uint64_t current_key;
+	Point current_point;
+
+	static void put(Block &block, std::uint64_t value) {
+		for (; value > 0x7f; value >>= 7)
+			block.push_back(value | 0x80);
+		block.push_back(value);
+	}
+
+	static void put(Block &block, std::int64_t value) {
+		put(block, static_cast<std::uint64_t>(value) << 1 ^ static_cast<std::uint64_t>(value >> 63));
+	}
+
+	auto get() {
+		auto value = std::uint64_t(0);
+		for (auto shift = 0; ; shift += 7) {
+			auto const byte = blocks.front()[position++];
+			value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+			if (byte < 0x80)
+				return value;
+		}
+	}
+
+	auto get_signed() {
+		auto const value = get();
+		return static_cast<std::int64_t>(value >> 1 ^ -(value & 1));
+	}
+
+	void decode(bool first) {
+		current_key = first ? get() : current_key + get();
+		current_point.x = first ? get_signed() : current_point.x + get_signed();
+		current_point.y = first ? get_signed() : current_point.y + get_signed();
+		std::memcpy(&current_point.elevation, blocks.front().data() + position, 4);
+		current_point.classification = blocks.front()[position + 4];
+		auto const flags = blocks.front()[position + 5];
+		current_point.key_point = flags & 1;
+		current_point.withheld = flags & 2;
+		current_point.overlap = flags & 4;
+		position += 6;
+	}
+
+public:
+	Packed(Keys const &keys, Points const &points) : remaining(points.size()), position(0), current_key(0), current_point() {
+		for (std::size_t index = 0; index < points.size(); ++index) {
+			auto const first = 0 == index % block_points;
+			if (first)
+				blocks.emplace_back();
+			auto &block = blocks.back();
+			auto const &point = points[index];
+			if (first) {
+				put(block, keys[index]);
+				put(block, std::int64_t(point.x));
+				put(block, std::int64_t(point.y));
+			} else {
+				put(block, keys[index] - keys[index - 1]);
+				put(block, std::int64_t(point.x) - points[index - 1].x);
+				put(block, std::int64_t(point.y) - points[index - 1].y);
+			}
+			unsigned char bytes[6];
+			std::memcpy(bytes, &point.elevation, 4);
+			bytes[4] = point.classification;
+			bytes[5] = point.key_point | point.withheld << 1 | point.overlap << 2;
+			block.insert(block.end(), bytes, bytes + 6);
+		}
+		for (auto &block: blocks)
+			block.shrink_to_fit();
+		if (remaining)
+			decode(true);
+	}
+
+	auto size() const {
+		return remaining;
+	}
+
+	auto key() const {
+		return current_key;
+	}
+
+	auto const &point() const {
+		return current_point;
+	}
+
+	auto next() {
+		if (0 == --remaining) {
+			blocks.clear();
+			return false;
+		}
+		if (position == blocks.front().size()) {
+			blocks.pop_front();
+			position = 0;
+			decode(true);
+		} else
+			decode(false);
+		return true;
+	}
+};
+
+#endif
@@ -7,22 +7,31 @@
 #ifndef PLY_HPP
 #define PLY_HPP
 
+#include "input.hpp"
 #include "srs.hpp"
-#include "point.hpp"
-#include <istream>
+#include "batch.hpp"
+#include "bounds.hpp"
 #include <string>
 #include <stdexcept>
 #include <sstream>
 #include <cstddef>
+#include <cstring>
 #include <bit>
 
 class PLY {
-	std::istream &input;
+	Input &input;
 
-	auto line() {
+	auto getline() {
 		auto string = std::string();
-		for (std::getline(input, string); string.rfind("comment", 0) == 0;)
-			std::getline(input, string);
+		for (char character; input.read(&character, 1), character != '\n'; )
+			string.push_back(character);
+		return string;
+	}
+
+	auto line() {
+		auto string = getline();
+		while (string.rfind("comment", 0) == 0)
+			string = getline();
 		return string;
 	}
 
@@ -41,9 +50,10 @@ class PLY {
 
 public:
 	std::size_t size;
+	Bounds bounds;
 	OptionalSRS srs;
 
-	PLY(std::istream &input) : input(input) {
+	PLY(Input &input) : input(input) {
 		if constexpr (std::endian::native == std::endian::big)
 			expect("format binary_big_endian 1.0");
 		else
@@ -56,14 +66,18 @@ public:
 		expect("end_header");
 	}
 
-	auto read() const {
-		double x, y, z;
-		unsigned char classification;
-		input.read(reinterpret_cast<char *>(&x), sizeof(x));
-		input.read(reinterpret_cast<char *>(&y), sizeof(y));
-		input.read(reinterpret_cast<char *>(&z), sizeof(z));
-		input.read(reinterpret_cast<char *>(&classification), sizeof(classification));
-		return Point(x, y, z, classification, false, false, 12 == classification);
+	void read(Batch &batch) {
+		for (std::size_t index = 0; index < batch.size; ++index) {
+			auto const buffer = input.view(3 * sizeof(double) + 1);
+			std::memcpy(&batch.x[index], buffer,                      sizeof(double));
+			std::memcpy(&batch.y[index], buffer +     sizeof(double), sizeof(double));
+			std::memcpy(&batch.z[index], buffer + 2 * sizeof(double), sizeof(double));
+			batch.classification[index] = buffer[3 * sizeof(double)];
+			batch.key_point[index] = false;
+			batch.withheld[index] = false;
+			batch.overlap[index] = 12 == batch.classification[index];
+		}
+		bounds += batch.bounds();
 	}
 };
 
@@ -12,14 +12,45 @@
 #include "bounds.hpp"
 #include <tuple>
 #include <type_traits>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 
-struct Point : Vertex {
+struct Point {
+	using Coordinate = std::int32_t;
+
+	static inline auto origin = Vertex{{0.0, 0.0}};
+	static inline auto quantum = 0.001;
+
+	static void frame(Bounds const &bounds, double reach) {
+		if (bounds.empty())
+			return;
+		auto const half_extent = std::max(bounds.xmax - bounds.xmin, bounds.ymax - bounds.ymin) / 2 + reach;
+		origin = Vertex{{(bounds.xmin + bounds.xmax) / 2, (bounds.ymin + bounds.ymax) / 2}};
+		quantum = half_extent / (1 << 30);
+	}
+
+	static auto quantise(double value, double origin) {
+		auto static constexpr limit = static_cast<double>(std::numeric_limits<Coordinate>::max());
+		auto const quantised = std::round((value - origin) / quantum);
+		if (!(std::abs(quantised) <= limit))
+			throw std::runtime_error("point coordinates out of range");
+		return static_cast<Coordinate>(quantised);
+	}
+
+	Coordinate x, y;
 	float elevation;
 	unsigned char classification;
-	bool key_point, withheld, overlap;
+	bool key_point : 1, withheld : 1, overlap : 1;
+
+	Point() = default;
 
 	Point(double x, double y, double z, unsigned char classification, bool key_point, bool withheld, bool overlap) :
-		Vertex{{x, y}},
+		x(quantise(x, origin[0])),
+		y(quantise(y, origin[1])),
 		elevation(z),
 		classification(classification),
 		key_point(key_point),
@@ -31,6 +62,19 @@ struct Point : Vertex {
 		Point(x, y, 0.0, 2, false, true, false)
 	{ }
 
+	auto operator[](std::size_t index) const {
+		return origin[index] + quantum * (index ? y : x);
+	}
+
+	operator Vertex() const {
+		return Vertex{{(*this)[0], (*this)[1]}};
+	}
+
+	template <std::size_t M>
+	auto get() const {
+		return (*this)[M];
+	}
+
 	auto ground() const {
 		return 2 == classification;
 	}
@@ -45,6 +89,14 @@ struct Point : Vertex {
 	}
 };
 
+auto operator<(Point const &p1, Point const &p2) {
+	return std::tuple(p1.x, p1.y) < std::tuple(p2.x, p2.y);
+}
+
+auto operator-(Point const &p1, Point const &p2) {
+	return Vertex(p1) - Vertex(p2);
+}
+
 auto operator+(Point const &point) {
 	return Vector<3>{{point[0], point[1], point.elevation}};
 }
@@ -63,8 +115,7 @@ struct std::tuple_element<M, Point> { using type = double; };
 
 template <>
 Bounds::Bounds(Point const &point) {
-	auto const &[x, y] = point;
-	xmin = xmax = x, ymin = ymax = y;
+	xmin = xmax = point[0], ymin = ymax = point[1];
 }
 
 #endif
@@ -14,114 +14,203 @@
 #include "thin.hpp"
 #include "fill.hpp"
 #include "tile.hpp"
+#include "tiles.hpp"
+#include "input.hpp"
+#include "queue.hpp"
+#include "cache.hpp"
+#include "packed.hpp"
+#include "lax.hpp"
 #include <vector>
+#include <optional>
 #include <filesystem>
 #include <unordered_set>
-#include <set>
 #include <iostream>
 #include <mutex>
 #include <exception>
 #include <stdexcept>
 #include <thread>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <utility>
 #include <cmath>
 #include <numeric>
 #include <cstddef>
+#include <cstdint>
 
 class Points : public std::vector<Point> {
 	using Path = std::filesystem::path;
-	using Paths = std::vector<Path>;
-	using PathIterator = Paths::const_iterator;
 	using Discard = std::unordered_set<unsigned char>;
+	using Keys = std::vector<std::uint64_t>;
+	using OptionalIntervals = std::optional<LAX::Intervals>;
 
-	std::vector<Bounds> tile_bounds;
-	std::set<OptionalSRS> distinct_srs;
+	friend struct Thin;
+	Keys keys;
 
-	void load(App const &app, Path const &path, Thin const &thin) {
-		try {
-			auto input = std::ifstream(path, std::ios::binary);
-			thin(app, *this, input);
-		} catch (std::ios_base::failure &) {
-			throw std::runtime_error(path.string() + ": problem reading file");
-		} catch (std::runtime_error &error) {
-			throw std::runtime_error(path.string() + ": " + error.what());
+	using Runs = std::vector<Points>;
+
+	static auto intervals(App const &app, Path const &path) {
+		auto const lax_path = Path(path).replace_extension(".lax");
+		auto intervals = OptionalIntervals();
+		if (app.bounds && std::filesystem::is_regular_file(lax_path)) {
+			auto input = Input(lax_path);
+			intervals = LAX(input, *app.bounds).intervals;
 		}
+		return intervals;
 	}
 
-	void load(App const &app, PathIterator begin, PathIterator end, Thin const &thin, std::mutex &mutex, std::exception_ptr &exception, int threads) {
+	static void load(App const &app, Path const &path, OptionalIntervals const &intervals, std::size_t begin, std::size_t end, Thin const &thin, Runs &runs, std::mutex &mutex, std::exception_ptr &exception, int threads) {
 		if (auto lock = std::lock_guard(mutex); exception)
 			return;
 		try {
-			if (begin + 1 == end) {
-				auto const &path = *begin;
-				load(app, path, thin);
+			if (1 == threads || begin + 1 == end) {
+				auto input = Input(path);
+				auto tile = Tile(input, thin.resolution, intervals, begin, end);
+				thin(app, runs.emplace_back(Points()), tile, threads);
 			} else {
 				auto const middle = begin + (end - begin) / 2;
-				auto points1 = Points();
-				auto points2 = Points();
-				if (1 == threads) {
-					points1.load(app, begin, middle, thin, mutex, exception, 1);
-					points2.load(app, middle, end, thin, mutex, exception, 1);
-				} else {
-					auto thread1 = std::thread([&]() {
-						points1.load(app, begin, middle, thin, mutex, exception, threads/2);
-					}), thread2 = std::thread([&]() {
-						points2.load(app, middle, end, thin, mutex, exception, threads - threads/2);
-					});
-					thread1.join(), thread2.join();
-				}
-				thin(*this, points1, points2);
+				auto runs1 = Runs();
+				auto runs2 = Runs();
+				auto thread1 = std::thread([&]() {
+					load(app, path, intervals, begin, middle, thin, runs1, mutex, exception, threads/2);
+				}), thread2 = std::thread([&]() {
+					load(app, path, intervals, middle, end, thin, runs2, mutex, exception, threads - threads/2);
+				});
+				thread1.join(), thread2.join();
+				std::move(runs1.begin(), runs1.end(), std::back_inserter(runs));
+				std::move(runs2.begin(), runs2.end(), std::back_inserter(runs));
 			}
-			if (app.srs)
-				distinct_srs = {app.srs};
-			if (distinct_srs.size() > 1)
-				throw std::runtime_error("dissimilar SRS or EPSG codes detected");
-		} catch (std::runtime_error &) {
+		} catch (std::ios_base::failure &) {
+			auto lock = std::lock_guard(mutex);
+			exception = std::make_exception_ptr(std::runtime_error(path.string() + ": problem reading file"));
+		} catch (std::runtime_error &error) {
 			auto lock = std::lock_guard(mutex);
-			exception = std::current_exception();
+			exception = std::make_exception_ptr(std::runtime_error(path.string() + ": " + error.what()));
 		}
 	}
 
-	Points() = default;
-
-public:
-	Points(App const &app, Path const &path) {
-		auto const thin = Thin();
-		load(app, path, thin);
-	}
-
-	Points(App const &app) {
-		auto const resolution = *app.width / std::sqrt(8.0);
-		auto const thin = Thin(resolution);
+	static void load(App const &app, Path const &path, Thin const &thin, Runs &runs, int threads) {
 		auto mutex = std::mutex();
 		auto exception = std::exception_ptr();
 
-		app.log("reading", app.tile_paths.size(), "tile");
-		load(app, app.tile_paths.begin(), app.tile_paths.end(), thin, mutex, exception, app.io_threads);
+		try {
+			auto const cacheable = app.cache && thin.resolution > Thin::min_resolution && std::filesystem::is_regular_file(path);
+			auto const cache = cacheable ? std::optional(Cache(app, path, thin.resolution)) : std::nullopt;
+			if (auto cached = std::vector<Point>(); cache && cache->read(cached)) {
+				thin(runs.emplace_back(Points()), cached, threads);
+				return;
+			}
+
+			auto const intervals = Points::intervals(app, path);
+			auto input = Input(path);
+			auto tile = Tile(input, thin.resolution, intervals);
+			if (1 == threads || tile.chunks() < 2)
+				thin(app, runs.emplace_back(Points()), tile, threads);
+			else
+				load(app, path, intervals, 0, tile.chunks(), thin, runs, mutex, exception, threads);
+
+			if (cache && !exception)
+				cache->write(runs);
+		} catch (std::ios_base::failure &) {
+			throw std::runtime_error(path.string() + ": problem reading file");
+		} catch (std::runtime_error &error) {
+			throw std::runtime_error(path.string() + ": " + error.what());
+		}
 
 		if (exception)
 			std::rethrow_exception(exception);
+	}
 
-		if (!app.land && size() > 2) {
-			app.log("synthesising extra points");
-			auto fill = Fill(tile_bounds, resolution);
-			fill(*this);
-		}
+	Points() = default;
+
+public:
+	OptionalSRS srs;
+
+	auto static constexpr max_size = std::size_t(std::numeric_limits<std::uint32_t>::max() / 6);
+
+	static auto resolution(double width) {
+		return width / std::sqrt(8.0);
 	}
 
-	void update(Tile &tile) {
-		if (tile.bounds.empty())
-			return;
-		tile_bounds.push_back(tile.bounds);
-		distinct_srs.insert(tile.srs());
+	static auto resolution(App const &app) {
+		return resolution(*app.width);
 	}
 
-	void update(Points &points) {
-		tile_bounds.insert(tile_bounds.end(), points.tile_bounds.begin(), points.tile_bounds.end());
-		distinct_srs.insert(points.distinct_srs.begin(), points.distinct_srs.end());
+	Points(App const &app, Path const &path, int threads, Thin const &thin = Thin()) {
+		auto runs = Runs();
+
+		load(app, path, thin, runs, threads);
+		thin(*this, runs);
 	}
 
-	auto srs() const {
-		return distinct_srs.empty() ? OptionalSRS() : *distinct_srs.begin();
+	struct Decoded {
+		double resolution;
+		std::vector<Packed> runs;
+	};
+
+	using Decodes = std::vector<std::optional<Decoded>>;
+
+	static auto decode(App const &app, Path const &path, Thin const &thin, int threads) {
+		auto runs = Runs();
+		load(app, path, thin, runs, threads);
+		auto decoded = Decoded{thin.resolution, {}};
+		for (auto &run: runs)
+			decoded.runs.emplace_back(run.keys, run), run = Points();
+		return decoded;
+	}
+
+	auto decode(Thin const &thin, int threads) const {
+		auto run = Points();
+		thin(run, *this, threads);
+		auto decoded = Decoded{thin.resolution, {}};
+		decoded.runs.emplace_back(run.keys, run);
+		return decoded;
+	}
+
+	Points(App const &app, Tiles const &tiles, Decodes &decoded) : srs(tiles.srs) {
+		auto const resolution = Points::resolution(app);
+		auto const thin = Thin(resolution);
+		auto indices = Queue::Indices();
+		for (std::size_t index = 0; index < tiles.bounds.size(); ++index)
+			if (!tiles.bounds[index].empty())
+				indices.push_back(index);
+
+		auto const queue = Queue(app.tile_paths, indices, app.prefetch, app.budget);
+		auto tile_runs = std::vector<Runs>(app.tile_paths.size());
+
+		auto total = std::atomic<std::size_t>(0);
+		app.log("reading", indices.size(), "tile");
+		queue(app.io_threads, [&](std::size_t index, int threads) {
+			auto const held = index < decoded.size() && decoded[index] ? &*decoded[index] : nullptr;
+			if (held && held->resolution == resolution)
+				for (auto &packed: held->runs) {
+					auto &run = tile_runs[index].emplace_back(Points());
+					run.reserve(packed.size()), run.keys.reserve(packed.size());
+					for (auto more = packed.size() > 0; more; more = packed.next())
+						run.keys.push_back(packed.key()), run.push_back(packed.point());
+				}
+			else if (held && held->resolution < resolution)
+				thin(tile_runs[index].emplace_back(Points()), held->runs, threads);
+			else
+				load(app, app.tile_paths[index], thin, tile_runs[index], threads);
+			if (index < decoded.size())
+				decoded[index].reset();
+			for (auto const &run: tile_runs[index])
+				if ((total += run.size()) > max_size)
+					throw std::runtime_error("too many points, increase --width");
+		});
+
+		auto runs = Runs();
+		for (auto &tile_run: tile_runs)
+			std::move(tile_run.begin(), tile_run.end(), std::back_inserter(runs));
+		thin(*this, runs);
+
+		if (!app.land && size() > 2) {
+			app.log("synthesising extra points");
+			auto fill = Fill(tiles.bounds, resolution);
+			fill(*this);
+		}
 	}
 };
 
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include <vector>
+#include <filesystem>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+
+class Prefetch {
+	using Paths = std::vector<std::filesystem::path>;
+	using Indices = std::vector<std::size_t>;
+	using Sizes = std::vector<std::uintmax_t>;
+
+	std::size_t static constexpr block_size = 1 << 20;
+
+	Paths const &paths;
+	Indices const &order;
+	Sizes const &sizes;
+	std::size_t depth;
+	std::uintmax_t budget;
+
+	std::size_t started;
+	bool stopped;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread thread;
+
+	auto ready(std::size_t position) const {
+		if (stopped || position < started)
+			return true;
+		if (position >= started + depth)
+			return false;
+		auto ahead = std::uintmax_t(0);
+		for (auto index = started; index <= position; ++index)
+			ahead += sizes[index];
+		return position == started || ahead <= budget;
+	}
+
+	auto taken(std::size_t position) {
+		auto lock = std::lock_guard(mutex);
+		return stopped || position < started;
+	}
+
+	void fetch(std::size_t position, std::vector<char> &buffer) {
+		if (0 == sizes[position])
+			return;
+		auto const descriptor = ::open(paths[order[position]].c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return;
+		::posix_fadvise(descriptor, 0, 0, POSIX_FADV_WILLNEED);
+		for (auto offset = std::uintmax_t(0); offset < std::min(sizes[position], budget) && !taken(position); offset += block_size)
+			if (::pread(descriptor, buffer.data(), block_size, offset) <= 0)
+				break;
+		::close(descriptor);
+	}
+
+	void run() {
+		auto buffer = std::vector<char>(block_size);
+		for (std::size_t position = 0; position < order.size(); ++position) {
+			{
+				auto lock = std::unique_lock(mutex);
+				condition.wait(lock, [&]() { return ready(position); });
+				if (stopped)
+					return;
+				if (position < started)
+					continue;
+			}
+			fetch(position, buffer);
+		}
+	}
+
+public:
+	Prefetch(Paths const &paths, Indices const &order, Sizes const &sizes, std::size_t depth, std::uintmax_t budget) :
+		paths(paths),
+		order(order),
+		sizes(sizes),
+		depth(depth),
+		budget(budget),
+		started(0),
+		stopped(false),
+		thread([this]() { run(); })
+	{ }
+
+	~Prefetch() {
+		{
+			auto lock = std::lock_guard(mutex);
+			stopped = true;
+		}
+		condition.notify_one();
+		thread.join();
+	}
+
+	void operator()(std::size_t position) {
+		{
+			auto lock = std::lock_guard(mutex);
+			started = std::max(started, position + 1);
+		}
+		condition.notify_one();
+	}
+};
+
+#endif
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef QUEUE_HPP
+#define QUEUE_HPP
+
+#include "prefetch.hpp"
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+
+class Queue {
+	using Paths = std::vector<std::filesystem::path>;
+	using Sizes = std::vector<std::uintmax_t>;
+
+	Paths const &paths;
+	std::vector<std::size_t> order;
+	Sizes sizes;
+	std::size_t depth;
+	std::uintmax_t budget;
+
+public:
+	using Indices = std::vector<std::size_t>;
+
+	Queue(Paths const &paths, Indices const &indices, std::size_t depth = 0, std::uintmax_t budget = 0) :
+		paths(paths),
+		order(indices),
+		depth(depth),
+		budget(budget)
+	{
+		auto unsorted = Sizes();
+		for (auto const index: order) {
+			auto error = std::error_code();
+			auto const size = std::filesystem::file_size(paths[index], error);
+			unsorted.push_back(error ? 0 : size);
+		}
+		auto positions = Indices(order.size());
+		std::iota(positions.begin(), positions.end(), 0);
+		std::stable_sort(positions.begin(), positions.end(), [&](auto position1, auto position2) {
+			return unsorted[position1] > unsorted[position2];
+		});
+		for (auto &position: positions)
+			sizes.push_back(unsorted[position]), position = order[position];
+		order.swap(positions);
+	}
+
+	Queue(Paths const &paths) : Queue(paths, [&]() {
+		auto indices = Indices(paths.size());
+		std::iota(indices.begin(), indices.end(), 0);
+		return indices;
+	}()) { }
+
+	template <typename Function>
+	void operator()(int threads, Function const &function) const {
+		auto const workers = std::clamp<std::size_t>(order.size(), 1, threads);
+		auto const tile_threads = [&](std::size_t worker) {
+			return static_cast<int>(threads / workers + (worker < threads % workers));
+		};
+		auto next = std::atomic<std::size_t>(0);
+		auto mutex = std::mutex();
+		auto exception = std::exception_ptr();
+		auto prefetch = std::optional<Prefetch>();
+		if (depth > 0 && order.size() > 1)
+			prefetch.emplace(paths, order, sizes, depth, budget);
+
+		auto const work = [&](int tile_threads) {
+			for (auto position = next++; position < order.size(); position = next++) {
+				if (prefetch)
+					(*prefetch)(position);
+				if (auto lock = std::lock_guard(mutex); exception)
+					return;
+				try {
+					function(order[position], tile_threads);
+				} catch (std::runtime_error &) {
+					auto lock = std::lock_guard(mutex);
+					exception = std::current_exception();
+				}
+			}
+		};
+
+		auto pool = std::vector<std::thread>();
+		for (std::size_t worker = 1; worker < workers; ++worker)
+			pool.emplace_back(work, tile_threads(worker));
+		work(tile_threads(0));
+		for (auto &thread: pool)
+			thread.join();
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+};
+
+#endif
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RADIX_HPP
+#define RADIX_HPP
+
+#include <vector>
+#include <array>
+#include <thread>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+template <typename Values>
+void radix_sort(std::vector<std::uint64_t> &keys, Values &values, int threads) {
+	using Counts = std::array<std::size_t, 256>;
+
+	auto const size = keys.size();
+	auto const blocks = std::clamp<std::size_t>(size / 65536, 1, threads);
+	auto const block_begin = [&](std::size_t block) { return size * block / blocks; };
+
+	auto const parallel = [&](auto const &function) {
+		auto workers = std::vector<std::thread>();
+		for (std::size_t block = 1; block < blocks; ++block)
+			workers.emplace_back(function, block);
+		function(0);
+		for (auto &worker: workers)
+			worker.join();
+	};
+
+	auto all_and = ~std::uint64_t(0), all_or = std::uint64_t(0);
+	for (auto const key: keys)
+		all_and &= key, all_or |= key;
+
+	auto keys_buffer = std::vector<std::uint64_t>();
+	auto values_buffer = Values();
+	auto counts = std::vector<Counts>(blocks);
+
+	for (auto shift = 0; shift < 64; shift += 8) {
+		if (0 == ((all_and ^ all_or) >> shift & 0xff))
+			continue;
+		if (keys_buffer.empty())
+			keys_buffer.resize(size), values_buffer = values;
+
+		parallel([&](std::size_t block) {
+			auto &count = counts[block];
+			count.fill(0);
+			for (auto index = block_begin(block); index < block_begin(block + 1); ++index)
+				++count[keys[index] >> shift & 0xff];
+		});
+
+		auto total = std::size_t(0);
+		for (std::size_t digit = 0; digit < 256; ++digit)
+			for (auto &count: counts)
+				total += std::exchange(count[digit], total);
+
+		parallel([&](std::size_t block) {
+			auto &offsets = counts[block];
+			for (auto index = block_begin(block); index < block_begin(block + 1); ++index) {
+				auto const offset = offsets[keys[index] >> shift & 0xff]++;
+				keys_buffer[offset] = keys[index];
+				values_buffer[offset] = values[index];
+			}
+		});
+
+		std::swap(keys, keys_buffer);
+		std::swap(values, values_buffer);
+	}
+}
+
+#endif
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include "app.hpp"
+#include "points.hpp"
+#include "thin.hpp"
+#include "tiles.hpp"
+#include "bounds.hpp"
+#include "point.hpp"
+#include <vector>
+#include <optional>
+#include <string>
+#include <iostream>
+#include <utility>
+#include <mutex>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <cstddef>
+
+class Stream {
+	auto static constexpr reach = 1'000'000.0;
+
+public:
+	Tiles::Scans scans;
+	Points::Decodes decoded;
+
+	Stream(App &app) {
+		if (!app.stream)
+			return;
+
+		auto const thin = Thin(Points::resolution(app));
+		auto framed = std::once_flag();
+		auto mutex = std::mutex();
+		auto exception = std::exception_ptr();
+
+		auto const work = [&]() {
+			for (auto line = std::string(); ; ) {
+				auto index = std::size_t();
+				{
+					auto lock = std::lock_guard(mutex);
+					if (exception || !std::getline(std::cin, line))
+						return;
+					index = app.tile_paths.size();
+					app.tile_paths.emplace_back(line);
+					scans.emplace_back();
+					decoded.emplace_back();
+				}
+				try {
+					auto const scan = Tiles::scan(line);
+					if (!scan.bounds.empty())
+						std::call_once(framed, [&]() {
+							Point::frame(scan.bounds, reach);
+						});
+					auto points = app.bounds && !(scan.bounds & *app.bounds) ? std::nullopt : std::optional(Points::decode(app, line, thin, 1));
+					auto lock = std::lock_guard(mutex);
+					scans[index] = scan;
+					decoded[index] = std::move(points);
+				} catch (std::runtime_error &) {
+					auto lock = std::lock_guard(mutex);
+					exception = std::current_exception();
+				}
+			}
+		};
+
+		app.log("streaming tiles");
+		auto pool = std::vector<std::thread>();
+		for (int worker = 1; worker < app.io_threads; ++worker)
+			pool.emplace_back(work);
+		work();
+		for (auto &thread: pool)
+			thread.join();
+
+		if (exception)
+			std::rethrow_exception(exception);
+		if (app.tile_paths.empty())
+			throw std::runtime_error("missing argument: LAS input path");
+	}
+};
+
+#endif
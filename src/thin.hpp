@@ -10,13 +10,17 @@
 #include "point.hpp"
 #include "app.hpp"
 #include "tile.hpp"
+#include "batch.hpp"
+#include "radix.hpp"
+#include "packed.hpp"
 #include <limits>
-#include <stdexcept>
-#include <utility>
-#include <istream>
-#include <algorithm>
+#include <queue>
 #include <functional>
-#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 struct Thin {
 	auto static constexpr web_mercator_range = 40097932.2;
@@ -29,54 +33,182 @@ struct Thin {
 			throw std::runtime_error("width value too small");
 	}
 
-	auto operator()(Point const &p1, Point const &p2) const {
-		return
-			std::pair<int, int>(p1[0] / resolution, p1[1] / resolution) <
-			std::pair<int, int>(p2[0] / resolution, p2[1] / resolution);
+	template <typename Points>
+	class Cells {
+		using Slots = std::vector<std::uint32_t>;
+
+		Points &points;
+		std::vector<std::uint64_t> &keys;
+		Slots slots;
+		int shift;
+
+		auto slot(std::uint64_t key) const {
+			return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> shift);
+		}
+
+		void grow() {
+			slots.assign(2 * slots.size(), 0);
+			--shift;
+			for (std::size_t index = 0; index < keys.size(); ++index) {
+				auto here = slot(keys[index]);
+				for (auto const mask = slots.size() - 1; slots[here]; here = (here + 1) & mask) ;
+				slots[here] = index + 1;
+			}
+		}
+
+	public:
+		Cells(Points &points, std::size_t capacity) : points(points), keys(points.keys), slots(2), shift(63) {
+			points.reserve(capacity);
+			keys.reserve(capacity);
+			while (slots.size() < 2 * capacity)
+				slots.resize(2 * slots.size()), --shift;
+		}
+
+		void insert(std::uint64_t key, Point const &point) {
+			if (2 * keys.size() >= slots.size())
+				grow();
+			for (auto here = slot(key), mask = slots.size() - 1; ; here = (here + 1) & mask)
+				if (auto const index = slots[here]; !index) {
+					slots[here] = keys.size() + 1;
+					keys.push_back(key);
+					points.push_back(point);
+					return;
+				} else if (keys[index - 1] == key) {
+					if (point > points[index - 1])
+						points[index - 1] = point;
+					return;
+				}
+		}
+	};
+
+	auto key(double x, double y) const {
+		auto const column = static_cast<std::uint32_t>(static_cast<int>(x / resolution)) ^ 0x80000000u;
+		auto const row    = static_cast<std::uint32_t>(static_cast<int>(y / resolution)) ^ 0x80000000u;
+		return static_cast<std::uint64_t>(column) << 32 | row;
 	}
 
 	template <typename Points>
-	void operator()(App const &app, Points &points, std::istream &input) const {
-		auto tile = Tile(input);
-		points.reserve(tile.size());
-
-		for (auto const point: tile)
-			if (!point.withheld && (point.key_point || !app.discard.contains(point.classification)))
-				points.push_back(point);
-		std::sort(points.begin(), points.end(), *this);
-
-		auto here = points.begin();
-		auto const points_end = points.end();
-		for (auto range_begin = points.begin(); range_begin != points_end; ++here) {
-			auto const range_end = std::upper_bound(range_begin, points_end, *range_begin, *this);
-			*here = *std::min_element(range_begin, range_end, std::greater());
-			range_begin = range_end;
+	void operator()(App const &app, Points &points, Tile &tile, int threads) const {
+		auto discard = Batch::Discard();
+		for (auto const classification: app.discard)
+			discard[classification] = true;
+
+		auto capacity = tile.size();
+		if (auto const bounds = tile.bounds(); !bounds.empty()) {
+			auto const columns = (bounds.xmax - bounds.xmin) / resolution + 2;
+			auto const rows    = (bounds.ymax - bounds.ymin) / resolution + 2;
+			if (columns * rows < capacity)
+				capacity = columns * rows;
 		}
 
-		points.erase(here, points_end);
-		points.update(tile);
+		auto cells = Cells<Points>(points, capacity);
+		for (auto batch = Batch(); tile.read(batch); ) {
+			batch.filter(discard);
+			if (app.bounds)
+				batch.clip(*app.bounds);
+			for (std::size_t index = 0; index < batch.size; ++index)
+				if (batch.accept[index]) {
+					auto const point = batch[index];
+					cells.insert(key(point[0], point[1]), point);
+				}
+		}
+		radix_sort(points.keys, static_cast<std::vector<Point> &>(points), threads);
+	}
+
+	template <typename Points, typename Source>
+	void operator()(Points &points, Source const &source, int threads) const {
+		auto cells = Cells<Points>(points, source.size());
+		for (auto const &point: source)
+			cells.insert(key(point[0], point[1]), point);
+		radix_sort(points.keys, static_cast<std::vector<Point> &>(points), threads);
 	}
 
 	template <typename Points>
-	void operator()(Points &points, Points &points1, Points &points2) const {
-		points.reserve(points1.size() + points2.size());
-
-		auto point1 = points1.begin(), point2 = points2.begin();
-		auto const end1 = points1.end(), end2 = points2.end();
-		while (point1 != end1 && point2 != end2)
-			if ((*this)(*point1, *point2))
-				points.push_back(*point1++);
-			else if ((*this)(*point2, *point1))
-				points.push_back(*point2++);
-			else {
-				points.push_back(*point1 > *point2 ? *point1 : *point2);
-				++point1, ++point2;
+	void operator()(Points &points, std::vector<Packed> &sources, int threads) const {
+		auto size = std::size_t(0);
+		for (auto const &source: sources)
+			size += source.size();
+
+		auto cells = Cells<Points>(points, size);
+		for (auto &source: sources)
+			for (auto more = source.size() > 0; more; more = source.next())
+				cells.insert(key(source.point()[0], source.point()[1]), source.point());
+		sources.clear();
+		radix_sort(points.keys, static_cast<std::vector<Point> &>(points), threads);
+	}
+
+	template <typename Points>
+	class Run {
+		Points &points;
+		std::size_t position;
+
+	public:
+		Run(Points &points) : points(points), position(0) { }
+
+		auto size() const {
+			return points.size() - position;
+		}
+
+		auto key() const {
+			return points.keys[position];
+		}
+
+		auto const &point() const {
+			return points[position];
+		}
+
+		auto next() {
+			if (++position < points.size())
+				return true;
+			points = {};
+			return false;
+		}
+	};
+
+	template <typename Cursors>
+	static void merge(std::vector<Point> &points, Cursors &cursors) {
+		using Head = std::pair<std::uint64_t, std::size_t>;
+		using Heads = std::priority_queue<Head, std::vector<Head>, std::greater<Head>>;
+
+		auto size = std::size_t(0);
+		for (auto const &cursor: cursors)
+			size += cursor.size();
+		points.reserve(size);
+
+		auto heads = Heads();
+		auto const advance = [&](std::size_t index) {
+			if (cursors[index].next())
+				heads.emplace(cursors[index].key(), index);
+		};
+
+		for (std::size_t index = 0; index < cursors.size(); ++index)
+			if (cursors[index].size())
+				heads.emplace(cursors[index].key(), index);
+
+		while (!heads.empty()) {
+			auto const [key, index] = heads.top();
+			heads.pop();
+			points.push_back(cursors[index].point());
+			advance(index);
+			while (!heads.empty() && heads.top().first == key) {
+				auto const other = heads.top().second;
+				heads.pop();
+				if (auto const &point = cursors[other].point(); point > points.back())
+					points.back() = point;
+				advance(other);
 			}
-		std::copy(point1, end1, std::back_inserter(points));
-		std::copy(point2, end2, std::back_inserter(points));
+		}
+	}
+
+	template <typename Points>
+	void operator()(std::vector<Point> &points, std::vector<Points> &runs) const {
+		if (1 == runs.size()) {
+			points.swap(runs.front());
+			return;
+		}
 
-		points.update(points1);
-		points.update(points2);
+		auto cursors = std::vector<Run<Points>>(runs.begin(), runs.end());
+		merge(points, cursors);
 	}
 };
 
@@ -7,26 +7,30 @@
 #ifndef TILE_HPP
 #define TILE_HPP
 
+#include "input.hpp"
 #include "ply.hpp"
 #include "las.hpp"
+#include "lax.hpp"
 #include "bounds.hpp"
+#include "batch.hpp"
 #include "srs.hpp"
 #include <variant>
-#include <istream>
+#include <optional>
 #include <array>
 #include <utility>
 #include <stdexcept>
+#include <algorithm>
 #include <cstddef>
 
 class Tile {
 	using Variant = std::variant<PLY, LAS>;
+	using OptionalIntervals = std::optional<LAX::Intervals>;
 
-	auto static from(std::istream &input) {
+	auto static from(Input &input) {
 		std::array<char, 4> static constexpr las_magic = {'L','A','S','F'};
 		std::array<char, 4> static constexpr ply_magic = {'p','l','y','\n'};
 		std::array<char, 4> magic;
 
-		input.exceptions(std::istream::failbit | std::istream::badbit);
 		input.read(magic.data(), magic.size());
 
 		if (magic == ply_magic)
@@ -36,37 +40,8 @@ class Tile {
 		throw std::runtime_error("unrecognised file format");
 	}
 
-	auto read() {
-		auto const read = [](auto &tile) { return tile.read(); };
-		auto const point = std::visit(read, variant);
-		bounds += Bounds(point);
-		return point;
-	}
-
 	Variant variant;
-
-	struct Iterator {
-		Tile &tile;
-		std::size_t index;
-
-		Iterator(Tile &tile, std::size_t index) :
-			tile(tile),
-			index(index)
-		{ }
-
-		auto &operator++() {
-			++index;
-			return *this;
-		}
-
-		auto operator!=(Iterator const &other) const {
-			return index != other.index;
-		}
-
-		auto operator*() const {
-			return tile.read();
-		}
-	};
+	std::size_t remaining;
 
 	struct GetSRS {
 		auto const &operator()(PLY &ply) const { return ply.srs; }
@@ -74,21 +49,51 @@ class Tile {
 	};
 
 public:
-	Bounds bounds;
-
-	Tile(std::istream &input) : variant(from(input)) { }
-
 	auto size() const {
 		auto const size = [](auto const &tile) { return tile.size; };
 		return std::visit(size, variant);
 	}
 
+	Tile(Input &input) :
+		variant(from(input)),
+		remaining(size())
+	{ }
+
+	Tile(Input &input, double resolution, OptionalIntervals const &intervals) : Tile(input) {
+		if (auto const las = std::get_if<LAS>(&variant)) {
+			las->prune(resolution);
+			if (intervals)
+				las->select(*intervals);
+		}
+		remaining = size();
+	}
+
+	Tile(Input &input, double resolution, OptionalIntervals const &intervals, std::size_t first_chunk, std::size_t last_chunk) : Tile(input, resolution, intervals) {
+		if (auto const las = std::get_if<LAS>(&variant))
+			las->chunks(first_chunk, last_chunk);
+		remaining = size();
+	}
+
+	auto chunks() const {
+		auto const las = std::get_if<LAS>(&variant);
+		return las ? las->chunks() : 1;
+	}
+
 	auto srs() {
 		return std::visit(GetSRS(), variant);
 	}
 
-	auto begin() { return Iterator(*this, 0); }
-	auto   end() { return Iterator(*this, size()); }
+	auto bounds() const {
+		auto const bounds = [](auto const &tile) { return tile.bounds; };
+		return std::visit(bounds, variant);
+	}
+
+	auto read(Batch &batch) {
+		batch.size = std::min(remaining, Batch::capacity);
+		remaining -= batch.size;
+		std::visit([&](auto &tile) { tile.read(batch); }, variant);
+		return batch.size > 0;
+	}
 };
 
 #endif
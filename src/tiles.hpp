@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2021 Matthew Hollingworth.
+// Distributed under GNU General Public License version 3.
+// See LICENSE file for full license information.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TILES_HPP
+#define TILES_HPP
+
+#include "app.hpp"
+#include "input.hpp"
+#include "tile.hpp"
+#include "batch.hpp"
+#include "bounds.hpp"
+#include "point.hpp"
+#include "srs.hpp"
+#include "queue.hpp"
+#include <vector>
+#include <filesystem>
+#include <set>
+#include <algorithm>
+#include <ios>
+#include <stdexcept>
+#include <cstddef>
+
+class Tiles {
+	using Path = std::filesystem::path;
+
+	auto static constexpr reach = 1000.0;
+
+	static Bounds extent(Tile &tile) {
+		auto static constexpr tolerance = 0.001;
+		auto batch = Batch();
+		auto bounds = tile.bounds();
+		if (!tile.read(batch))
+			return bounds;
+
+		auto padded = bounds;
+		padded.xmin -= tolerance, padded.xmax += tolerance;
+		padded.ymin -= tolerance, padded.ymax += tolerance;
+		if (bounds.xmin < bounds.xmax && bounds.ymin < bounds.ymax && batch.bounds() <= padded)
+			return bounds;
+
+		for (bounds = batch.bounds(); tile.read(batch); )
+			bounds += batch.bounds();
+		return bounds;
+	}
+
+public:
+	struct Scan {
+		Bounds bounds;
+		std::size_t size = 0;
+		OptionalSRS srs;
+	};
+
+	using Scans = std::vector<Scan>;
+
+	static auto scan(Path const &path) {
+		try {
+			auto input = Input(path);
+			auto tile = Tile(input);
+			auto const bounds = extent(tile);
+			return Scan{bounds, tile.size(), tile.srs()};
+		} catch (std::ios_base::failure &) {
+			throw std::runtime_error(path.string() + ": problem reading file");
+		} catch (std::runtime_error &error) {
+			throw std::runtime_error(path.string() + ": " + error.what());
+		}
+	}
+
+	std::vector<Bounds> bounds;
+	std::vector<std::size_t> sizes;
+	OptionalSRS srs;
+
+	Tiles(App const &app, Scans scans) :
+		bounds(app.tile_paths.size()),
+		sizes(app.tile_paths.size())
+	{
+		if (scans.size() != app.tile_paths.size()) {
+			auto const queue = Queue(app.tile_paths);
+			scans.resize(app.tile_paths.size());
+			app.log("scanning", app.tile_paths.size(), "tile");
+			queue(app.io_threads, [&](std::size_t index, int) {
+				scans[index] = scan(app.tile_paths[index]);
+			});
+		}
+
+		for (std::size_t index = 0; index < scans.size(); ++index)
+			bounds[index] = scans[index].bounds, sizes[index] = scans[index].size;
+
+		if (app.bounds) {
+			for (std::size_t index = 0; index < bounds.size(); ++index)
+				if (bounds[index] & *app.bounds) {
+					bounds[index].xmin = std::max(bounds[index].xmin, app.bounds->xmin);
+					bounds[index].ymin = std::max(bounds[index].ymin, app.bounds->ymin);
+					bounds[index].xmax = std::min(bounds[index].xmax, app.bounds->xmax);
+					bounds[index].ymax = std::min(bounds[index].ymax, app.bounds->ymax);
+				} else
+					bounds[index] = Bounds(), sizes[index] = 0;
+			if (Bounds(bounds).empty())
+				throw std::runtime_error("no tiles within bounds");
+		}
+
+		if (!app.stream)
+			Point::frame(Bounds(bounds), std::max(reach, 2 * app.width.value_or(0)));
+
+		auto distinct_srs = std::set<OptionalSRS>();
+		for (std::size_t index = 0; index < scans.size(); ++index)
+			if (!bounds[index].empty())
+				distinct_srs.insert(scans[index].srs);
+
+		if (app.srs)
+			srs = app.srs;
+		else if (distinct_srs.size() > 1)
+			throw std::runtime_error("dissimilar SRS or EPSG codes detected");
+		else if (!distinct_srs.empty())
+			srs = *distinct_srs.begin();
+	}
+};
+
+#endif